@@ -21,9 +21,27 @@ typedef enum eRoutinMethodeVariant
 {
 	ROUTING_METHODE_VARIANT_1 = 0x01,
 	ROUTING_METHODE_VARIANT_2 = 0x02,
-	ROUTING_METHODE_VARIANT_3 = 0x03
+	ROUTING_METHODE_VARIANT_3 = 0x03,
+	ROUTING_METHODE_VARIANT_4 = 0x04,
+	ROUTING_METHODE_VARIANT_5 = 0x05
 }tRoutinMethodeVariant;
 
+typedef enum eQosClass
+{
+	QOS_CLASS_STRICT_PRIORITY = 0x00,		/* always sent before the weighted fair devices (flight critical streams) */
+	QOS_CLASS_WEIGHTED_FAIR = 0x01,			/* shares the links with the other weighted fair devices according to QOS_WEIGHT */
+	NOF_QOS_CLASSES = 0x02
+} tQosClass;
+
+typedef enum eRoutingState
+{
+	ROUTING_STATE_SINGLE_LINK = 0x00,			/* links with high Q: the best link is used (Case 1) */
+	ROUTING_STATE_REDUNDANT_FREE_LINKS = 0x01,	/* links with mid Q: redundant sending on all free links (Case 2) */
+	ROUTING_STATE_REDUNDANT_ALL_LINKS = 0x02,	/* links with low Q: redundant sending on all links (Case 3) */
+	ROUTING_STATE_PANIC = 0x03,					/* no link is good enough: all links, only the prio device sends (Case 4) */
+	NOF_ROUTING_STATES = 0x04
+} tRoutingState;
+
 typedef enum eTestBenchRoutingAlgorithmModes
 {
 	TESTBENCH_OFF = 0x00,
@@ -48,17 +66,32 @@ typedef struct Configurations {
    int PrioDevice[NUMBER_OF_UARTS];
    int fallbackWirelessLink[NUMBER_OF_UARTS];
    int secondFallbackWirelessLink[NUMBER_OF_UARTS];
+   int QosClass[NUMBER_OF_UARTS]; /* tQosClass */
+   int QosWeight[NUMBER_OF_UARTS];
    /* TransmissionConfiguration */
    int ResendDelayWirelessConn; /* [delayPerWirelessConn] */
    int ResendCountWirelessConn; /* [delayPerWirelessConn] */
    int UsualPacketSizeDeviceConn[NUMBER_OF_UARTS];
+   bool AdaptivePacketSizeDeviceConn[NUMBER_OF_UARTS];
    int PackageGenMaxTimeout[NUMBER_OF_UARTS];
    int PayloadReorderingTimeout;
    tRoutingMethode RoutingMethode;
    tRoutinMethodeVariant RoutingMethodeVariant;
    bool UseProbingPacksWlConn[NUMBER_OF_UARTS];
+   int ProbeTrainLengthWlConn[NUMBER_OF_UARTS]; /* [packages] */
+   bool UsePassiveMetricsWlConn[NUMBER_OF_UARTS];
    int CostPerPacketMetric[NUMBER_OF_UARTS];
+   int RttFilterParam; /* [per mille] */
+   int SbppFilterParam; /* [per mille] */
+   int PlrHalfLife; /* [ms] */
+   int TrendHorizon; /* [ms], 0 = no link quality prediction */
+   int QthresholdEnter[NOF_ROUTING_STATES]; /* Q a link needs to enter the routing state */
+   int QthresholdExit[NOF_ROUTING_STATES]; /* the link leaves the routing state below this Q */
+   int RoutingStateMinDwell[NOF_ROUTING_STATES]; /* [ms] */
    bool UseGolayPerWlConn[NUMBER_OF_UARTS];
+   int CongestionWindowMaxDeviceConn[NUMBER_OF_UARTS]; /* [packages], 0 = no congestion control */
+   int FecParityGroupSize[NUMBER_OF_UARTS]; /* [packages], 0 = no parity packages */
+   int FecParityPacks[NUMBER_OF_UARTS]; /* [packages] per group, 0 = adapt to the packet loss ratio */
    /* SoftwareConfiguration */
    bool TestHwLoopbackOnly;
    bool EnableStressTest;
@@ -78,6 +111,9 @@ typedef struct Configurations {
    int ThroughputPrintoutTaskInterval_s; // [sec]
    int ShellTaskInterval; // [ms]
    int LoggerTaskInterval; // [ms]
+   bool EventDrivenTasks;
+   int EventDrivenFallbackInterval; // [ms]
+   bool RunToCompletionPipeline;
 } Configuration;
 
 extern Configuration config;
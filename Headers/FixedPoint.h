@@ -0,0 +1,82 @@
+/*
+ * FixedPoint.h
+ * Unsigned Q16.16 fixed-point arithmetic for the network metrics (no float on the K64F hot path).
+ * All operations saturate at FIXED_POINT_MAX instead of wrapping around.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HEADERS_FIXEDPOINT_H_
+#define HEADERS_FIXEDPOINT_H_
+
+#include <stdint.h>
+
+/*! \def FIXED_POINT_FRACTION_BITS
+*  \brief Number of fractional bits of tFixedPoint
+*/
+#define FIXED_POINT_FRACTION_BITS			16
+
+/*! \def FIXED_POINT_ONE
+*  \brief 1.0 in Q16.16
+*/
+#define FIXED_POINT_ONE						((tFixedPoint)1 << FIXED_POINT_FRACTION_BITS)
+
+/*! \def FIXED_POINT_MAX
+*  \brief Biggest value of tFixedPoint (65535.99998), results which do not fit are saturated to it
+*/
+#define FIXED_POINT_MAX						UINT32_MAX
+
+typedef uint32_t tFixedPoint; /* unsigned Q16.16 */
+
+/*!
+* \fn tFixedPoint fixedPoint_fromInt(uint32_t value)
+* \brief Converts an integer to Q16.16 (saturated)
+*/
+tFixedPoint fixedPoint_fromInt(uint32_t value);
+
+/*!
+* \fn tFixedPoint fixedPoint_fromPerMille(uint32_t perMille)
+* \brief Converts a value in per mille (1000 = 1.0) to Q16.16 (saturated)
+*/
+tFixedPoint fixedPoint_fromPerMille(uint32_t perMille);
+
+/*!
+* \fn uint16_t fixedPoint_toUint16(tFixedPoint value)
+* \brief Rounds to the nearest integer, saturated to 0xFFFF
+*/
+uint16_t fixedPoint_toUint16(tFixedPoint value);
+
+/*!
+* \fn tFixedPoint fixedPoint_add(tFixedPoint a, tFixedPoint b)
+* \brief a + b, saturated
+*/
+tFixedPoint fixedPoint_add(tFixedPoint a, tFixedPoint b);
+
+/*!
+* \fn tFixedPoint fixedPoint_mul(tFixedPoint a, tFixedPoint b)
+* \brief a * b, saturated
+*/
+tFixedPoint fixedPoint_mul(tFixedPoint a, tFixedPoint b);
+
+/*!
+* \fn tFixedPoint fixedPoint_div(tFixedPoint a, tFixedPoint b)
+* \brief a / b, saturated. Division by 0 returns FIXED_POINT_MAX (0 / 0 returns 0)
+*/
+tFixedPoint fixedPoint_div(tFixedPoint a, tFixedPoint b);
+
+/*!
+* \fn tFixedPoint fixedPoint_exponentialFilter(tFixedPoint y, tFixedPoint x, tFixedPoint a)
+* \brief Exponential filter y = a*y + (1-a)*x
+* \param a: filter parameter between 0 and FIXED_POINT_ONE (bigger = slower filter), limited to this range
+* \return the new filtered value
+*/
+tFixedPoint fixedPoint_exponentialFilter(tFixedPoint y, tFixedPoint x, tFixedPoint a);
+
+/*!
+* \fn tFixedPoint fixedPoint_pow2Neg(tFixedPoint x)
+* \brief 2^(-x), used as decay factor after x half-lives. The fraction of x is approximated with a
+*  quadratic polynomial (relative error < 0.3 % plus the Q16.16 resolution)
+*/
+tFixedPoint fixedPoint_pow2Neg(tFixedPoint x);
+
+#endif /* HEADERS_FIXEDPOINT_H_ */
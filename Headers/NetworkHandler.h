@@ -11,6 +11,18 @@
 */
 #define MAX_DELAY_NETW_HANDLER_MS				(0)
 
+/*! \def DUPLICATE_WINDOW_SIZE
+*  \brief Number of payloadNrs per device (up to the newest received one) for which redundant copies are
+*  recognized and dropped before they reach the transport handler. Needs to be a multiple of 32.
+*/
+#define DUPLICATE_WINDOW_SIZE					128
+
+/*! \def QOS_WFQ_QUANTUM
+*  \brief Bytes a weighted fair device with QOS_WEIGHT = 1 may send per deficit round robin round.
+*  Needs to be at least the size of the biggest package, so every device can send in every round.
+*/
+#define QOS_WFQ_QUANTUM							(sizeof(tWirelessPackage) + PACKAGE_MAX_PAYLOAD_SIZE)
+
 
 /*!
 * \fn void networkHandler_TaskEntry(void)
@@ -27,5 +39,18 @@ void networkHandler_TaskEntry(void* p);
 */
 void networkHandler_TaskInit(void);
 
+/*!
+* \fn void networkHandler_run(void)
+* \brief One cycle of the network handler: routes generated packages to the wireless connections and
+* passes assembled packages up to the transport handler.
+*/
+void networkHandler_run(void);
+
+/*!
+* \fn void networkHandler_notify(void)
+* \brief Wakes up the network handler task when EVENT_DRIVEN_TASKS is configured. Called by the tasks which put work into its queues.
+*/
+void networkHandler_notify(void);
+
 
 #endif
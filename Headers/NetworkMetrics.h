@@ -9,6 +9,7 @@
 #define HEADERS_NETWORKMETRICS_H_
 
 #include "PackageHandler.h"
+#include "Config.h" /* tRoutingState */
 
 /*! \def NETWORK_METRICS_QUEUE_DELAY
 *  \brief Number of ticks to wait on byte queue operations within this task
@@ -30,27 +31,117 @@
 */
 #define TIMEOUT_TEST_PACKET_RETURN     				2000
 
-/*! \def NOF_PACKS_FOR_PACKET_LOSS_RATIO
-*  \brief How many Test-Packets should be taken into account for the RLR metric
+/*! \def QUEUE_NOF_PASSIVE_METRIC_SAMPLES
+*  \brief Queue length of the sent data packages and received acknowledges used for the passive metrics
 */
-#define NOF_PACKS_FOR_PACKET_LOSS_RATIO     		20
+#define QUEUE_NOF_PASSIVE_METRIC_SAMPLES			50
 
+/*! \def PASSIVE_METRICS_NOF_OUTSTANDING_PACKS
+*  \brief Number of data packages per link whose acknowledge is awaited for the passive metrics
+*/
+#define PASSIVE_METRICS_NOF_OUTSTANDING_PACKS		16
+
+/*! \def PASSIVE_METRICS_MAX_AGE
+*  \brief Links without passive sample (acknowledged or lost data package) for this time are probed with test packets [ms]
+*/
+#define PASSIVE_METRICS_MAX_AGE						1000
+
+/*! \def PASSIVE_METRICS_PROBE_INTERVAL_CYCLES
+*  \brief Links measured on their data traffic are still probed every this many metrics task intervals,
+*  the acknowledged data only shows a lower bound of the bandwidth
+*/
+#define PASSIVE_METRICS_PROBE_INTERVAL_CYCLES		16
+
+/*! \def PASSIVE_METRICS_SBPP_DECAY_PERCENT
+*  \brief Per metrics task interval, the bandwidth estimation of a passively measured link sinks by this percentage
+*  towards the acknowledged bytes per second, until the next probe measures it again
+*/
+#define PASSIVE_METRICS_SBPP_DECAY_PERCENT			5
+
+/*! \def PROBE_INTERVAL_MAX_CYCLES
+*  \brief While Q of a link stays stable, its probe interval doubles up to this number of metrics task intervals
+*/
+#define PROBE_INTERVAL_MAX_CYCLES					16
+
+/*! \def PROBE_Q_STABLE_BAND_PERCENT
+*  \brief Q counts as stable if it changed less than this percentage since the last probe
+*/
+#define PROBE_Q_STABLE_BAND_PERCENT					10
+
+/*! \def PROBE_AIRTIME_BUDGET_PERCENT
+*  \brief Percentage of the baud rate of a link which the test packets may use at most (both directions)
+*/
+#define PROBE_AIRTIME_BUDGET_PERCENT				2
+
+/*! \def PROBE_PACK_AIRTIME_BYTES
+*  \brief Bytes one test package of a probe needs on the link: the package and its return (with the 2 fill bytes)
+*/
+#define PROBE_PACK_AIRTIME_BYTES					(2 * (TOTAL_WL_PACKAGE_SIZE + 2 + sizeof(tTestPackagePayload)))
+
+/*! \def PROBE_TRAIN_MAX_LENGTH
+*  \brief Maximal number of test packages sent back to back in one probe (packet train). 2 = packet pair
+*/
+#define PROBE_TRAIN_MAX_LENGTH						8
+
+/*! \def PROBE_NOF_RECORDS
+*  \brief Number of probes per link which can be outstanding at the same time. Needs to be a power of 2,
+*  the record of a probe is at probeNr % PROBE_NOF_RECORDS
+*/
+#define PROBE_NOF_RECORDS							64
 
-#define RRT_FILTER_PARAM 0.9
-#define SBPP_FILTER_PARAM 0.9
 #define MIN_RTT_RESEND_DELAY 50
 #define MAX_RTT_RESEND_DELAY 10000
 #define SECURITY_FACTOR_RTT_TO_RESEND_DELAY 2
 
 #define SCALING_FACTOR_SBPP_FOR_Q 10
 #define SCALING_DIVIDER_RTT_FOR_Q 6
-#define SCALING_DIVIDER_PLR_FOR_Q 6
+#define SCALING_DIVIDER_PLR_FOR_Q 60
+
+/*! \def TREND_LEVEL_PARAM
+*  \brief Weight of a new sample in the level of the trend estimator (double exponential smoothing) [per mille]
+*/
+#define TREND_LEVEL_PARAM 500
+
+/*! \def TREND_SLOPE_PARAM
+*  \brief Weight of the latest change of the level in the slope of the trend estimator [per mille]
+*/
+#define TREND_SLOPE_PARAM 200
+
+/*! \def SCALING_DIVIDER_GOLAY_FOR_PLR
+*  \brief Converts the projected rise of the Golay corrected words [per mille of the decoded words] into a rise of the
+*  packet loss ratio [per mille of the packages]. Corrected words are not lost, but only a part of the words with bit flips
+*  has more flips than Golay can correct, so a rising correction rate announces a smaller rise of the package losses.
+*/
+#define SCALING_DIVIDER_GOLAY_FOR_PLR 10
+
+/*! \def TREND_SCALE
+*  \brief Level and slope of the trend estimator are stored multiplied by this factor (fraction for slow trends)
+*/
+#define TREND_SCALE 256
 
 #define BANDWITH_USAGE_PER_CHANNEL 0.5
+#define NOF_BITS_PER_UART_BYTE 10
+
+/*! \def STRIPING_QUANTUM
+*  \brief Bytes the link with the highest bandwidth may send per deficit round robin round (striping).
+*  Needs to be at least the size of the biggest package so that every round sends something.
+*/
+#define STRIPING_QUANTUM (TOTAL_WL_PACKAGE_SIZE + PACKAGE_MAX_PAYLOAD_SIZE)
 
-#define Q_HIGH_THRESHOLD 300
-#define Q_MID_THRESHOLD 50
-#define Q_LOW_THRESHOLD 20
+/*! \def STRIPING_MAX_BACKLOG_MS
+*  \brief A link is skipped by the striping as long as its transmit backlog needs longer than this to be sent [ms]
+*/
+#define STRIPING_MAX_BACKLOG_MS 200
+
+/*! \def MAX_LINK_BACKLOG_MS
+*  \brief A link whose queued packages, TX byte queue and TX FIFO need longer than this to be sent out is avoided by the routing [ms]
+*/
+#define MAX_LINK_BACKLOG_MS 1000
+
+/*! \def MAX_EXPECTED_ARRIVAL_MS
+*  \brief Upper limit of the expected arrival time of a package on a link, to avoid overflows [ms]
+*/
+#define MAX_EXPECTED_ARRIVAL_MS 60000
 
 //#define PRINT_METRICS
 //#define PRINT_Q
@@ -72,6 +163,60 @@ typedef enum
 	ROUTING_ALGORITHM_RULE_PANIC_MODE
 } enumRoutingAlgoRules_t;
 
+/*! \struct sRoutingSnapshot
+*  \brief Routing decision of the metrics task. It is published double buffered with a sequence counter,
+*  so the network handler reads it for every package without taking a semaphore.
+*/
+typedef struct sRoutingSnapshot
+{
+	bool wirelessLinksToUse[NUMBER_OF_UARTS];
+	bool onlyPrioDeviceCanSend;
+	uint16_t Q[NUMBER_OF_UARTS];
+	uint8_t sortedQindexes[NUMBER_OF_UARTS];	// index 0 = link with the highest Q
+} tRoutingSnapshot;
+
+/*! \struct sLinkMetrics
+*  \brief Metrics and routing state of a wireless link, see networkMetrics_getSnapshot()
+*/
+typedef struct sLinkMetrics
+{
+	uint16_t RTTraw;				/* [ms] */
+	uint16_t RTTfiltered;			/* [ms] */
+	uint16_t SBPPraw;				/* [Byte/s] */
+	uint16_t SBPPfiltered;			/* [Byte/s] */
+	uint16_t PLR;					/* [per mille] */
+	uint16_t CPP;
+	uint16_t Q;
+	uint16_t Qpredicted;			/* Q projected TREND_HORIZON ahead */
+	tRoutingState linkState;		/* best routing state the Q of the link allows */
+	tRoutingState routingState;		/* routing state of the switch, the same for all links */
+	bool used;						/* the routing sends on this link */
+	uint16_t lastUpdateAge;			/* time since the metrics of the link were measured [ms], 0xFFFF = 65.5 s or longer */
+} tLinkMetrics;
+
+/*! \enum ePassiveMetricSampleType
+*  \brief Events on the data traffic which are used for the passive metrics
+*/
+typedef enum ePassiveMetricSampleType
+{
+	PASSIVE_SAMPLE_DATA_SENT,
+	PASSIVE_SAMPLE_ACK_RECEIVED
+} tPassiveMetricSampleType;
+
+/*! \struct sPassiveMetricSample
+*  \brief Sent data package or received acknowledge, passed to the network metrics task
+*/
+typedef struct sPassiveMetricSample
+{
+	tPassiveMetricSampleType type;
+	uint8_t wirelessLink;					/* link the data package was sent on / the acknowledge was received on */
+	uint8_t devNum;
+	uint16_t payloadNr;
+	uint16_t payloadNrLastInOrder;			/* acknowledge: all packages up to this payloadNr are received */
+	uint16_t bytes;							/* data package: bytes sent on the link */
+	TickType_t tickTime;
+} tPassiveMetricSample;
+
 /*!
 * \fn void networkMetrics_TaskEntry(void)
 * \brief Task computes the network metrics used for routing
@@ -93,20 +238,87 @@ void networkMetrics_TaskInit(void);
 uint16_t networkMetrics_getResendDelayWirelessConn(void);
 
 /*!
-* \fn  void networkMetrics_getLinksToUse(uint16_t bytesToSend,bool* wirelessLinksToUseParam)
+* \fn uint32_t networkMetrics_getBandwidth(void)
+* \brief estimates the bandwidth of all wireless links together in bytes per second.
+*  If no metrics are available, the configured baud rates are used.
+* \return bandwidth [Byte/s]
+*/
+uint32_t networkMetrics_getBandwidth(void);
+
+/*!
+* \fn uint16_t networkMetrics_getPacketLossRatio(void)
+* \brief returns the highest packet loss ratio of the links which are used at the moment (of all links if none is used).
+*  Only measured with ROUTING_METHODE = 2 and probing packs, 0 otherwise.
+* \return packet loss ratio [per mille]
+*/
+uint16_t networkMetrics_getPacketLossRatio(void);
+
+/*!
+* \fn void networkMetrics_getSnapshot(tLinkMetrics out[NUMBER_OF_UARTS])
+* \brief Copies the metrics of all wireless links as published with the last routing decision.
+*  Does not block, can be called from any task.
+*/
+void networkMetrics_getSnapshot(tLinkMetrics out[NUMBER_OF_UARTS]);
+
+/*!
+* \fn uint32_t networkMetrics_getRoutingSequence(void)
+* \brief returns a counter which changes every time the metrics task publishes a new routing decision
+*/
+uint32_t networkMetrics_getRoutingSequence(void);
+
+/*!
+* \fn uint32_t networkMetrics_getBandwidthDelayProduct(void)
+* \brief estimates how many bytes can be in flight on all wireless links together (bandwidth * RTT).
+*  If no metrics are available, the configured baud rates and RESEND_DELAY_WIRELESS_CONN are used.
+* \return bytes which can be in flight
+*/
+uint32_t networkMetrics_getBandwidthDelayProduct(void);
+
+/*!
+* \fn  void networkMetrics_getLinksToUse(uint16_t bytesToSend,bool* wirelessLinksToUseParam, uint16_t payloadNr, uint8_t sendTries, uint8_t deviceNr)
 *  in the Bool-Array wirelessLinksToUseParam the wireless links to use get saved. They are choosen by the routingAlgorithm
 *  if priorityData==true, the Data is handled with priority
+*  sendTries is the send attempt of the package (1 = first send), the redundancy is increased with every resend
+*  \return true, if packet has a link to be sent, false if no link is available at the moment
+*/
+bool networkMetrics_getLinksToUse(uint16_t bytesToSend,bool* wirelessLinksToUseParam, uint16_t payloadNr, uint8_t sendTries, uint8_t deviceNr);
+
+/*!
+* \fn bool networkMetrics_getParityLinkToUse(uint16_t bytesToSend, bool* wirelessLinksToUseParam, uint8_t deviceNr)
+* \brief Chooses one link for a FEC parity package out of the links of the last routing decision
 *  \return true, if packet has a link to be sent, false if no link is available at the moment
 */
-bool networkMetrics_getLinksToUse(uint16_t bytesToSend,bool* wirelessLinksToUseParam, uint16_t payloadNr, uint8_t deviceNr);
+bool networkMetrics_getParityLinkToUse(uint16_t bytesToSend, bool* wirelessLinksToUseParam, uint8_t deviceNr);
 
 /*!
-* \fn ByseType_t popFromRequestNewTestPacketPairQueue(bool* request)
+* \fn void networkMetrics_chargeLink(uint8_t wirelessLink, uint16_t bytesSent)
+* \brief Charges a package routed with networkMetrics_getLinksToUse() or networkMetrics_getParityLinkToUse() to the link
+*  once it is handed to the link: counts the bytes for the load balancing and the striping deficit.
+*  The routing itself charges nothing, so a deferred package can be routed again. Only called by the network handler.
+*/
+void networkMetrics_chargeLink(uint8_t wirelessLink, uint16_t bytesSent);
+
+/*!
+* \fn ByseType_t popFromRequestNewTestPacketPairQueue(uint8_t wirelessLink, bool* request)
 * \brief Pops a package from queue
+* \param wirelessLink: link which should be probed
 * \param request: Pointer to result
 * \return Status if xQueueReceive has been successful
 */
-BaseType_t popFromRequestNewTestPacketPairQueue(bool* request);
+BaseType_t popFromRequestNewTestPacketPairQueue(uint8_t wirelessLink, bool* request);
+
+/*!
+* \fn void networkMetrics_passiveDataPackageSent(uint8_t wirelessLink, tWirelessPackage* pPackage)
+* \brief Reports a data package which is sent on a single link, its acknowledge is used to measure the link passively.
+*  Packages sent on several links are not reported: their acknowledge does not tell which copy arrived.
+*/
+void networkMetrics_passiveDataPackageSent(uint8_t wirelessLink, tWirelessPackage* pPackage);
+
+/*!
+* \fn void networkMetrics_passiveAckReceived(uint8_t wirelessLink, uint8_t devNum, uint16_t payloadNr, uint16_t payloadNrLastInOrder)
+* \brief Reports a received acknowledge to the passive metrics
+*/
+void networkMetrics_passiveAckReceived(uint8_t wirelessLink, uint8_t devNum, uint16_t payloadNr, uint16_t payloadNrLastInOrder);
 
 /*!
 * \fn BaseType_t pushToTestPacketResultsQueue(tWirelessPackage* results);
@@ -21,6 +21,12 @@
 #else
 #define PACKAGE_BUFFER_SIZE					130						//Number of wireless packages in the buffer
 #endif
+
+/*! \def PAYLOAD_NR_HALF_RANGE
+*  \brief Half of the uint16_t payloadNr range. A payloadNr which is less than this distance ahead of
+*  another one counts as newer, even if the counter wrapped around in between (serial number arithmetic, RFC 1982)
+*/
+#define PAYLOAD_NR_HALF_RANGE				0x8000
 typedef struct sPackageBuffer
 {
 	tWirelessPackage packageArray[PACKAGE_BUFFER_SIZE];     		// data buffer
@@ -169,4 +175,18 @@ void packageBuffer_setCurrentPayloadNR(tPackageBuffer* buffer,uint16_t payloadNr
 * \brief returns the last payloadNr which was received
 */
 uint16_t packageBuffer_getCurrentPayloadNR(tPackageBuffer* buffer);
+
+/*!
+* \fn bool packageBuffer_isNewerPayloadNr(uint16_t payloadNr, uint16_t referencePayloadNr)
+* \brief Compares two payloadNrs wrap safe (RFC 1982)
+* \return true if payloadNr was generated after referencePayloadNr
+*/
+bool packageBuffer_isNewerPayloadNr(uint16_t payloadNr, uint16_t referencePayloadNr);
+
+/*!
+* \fn bool packageBuffer_isNewerOrEqualPayloadNr(uint16_t payloadNr, uint16_t referencePayloadNr)
+* \brief Compares two payloadNrs wrap safe (RFC 1982)
+* \return true if payloadNr is equal to referencePayloadNr or was generated after it
+*/
+bool packageBuffer_isNewerOrEqualPayloadNr(uint16_t payloadNr, uint16_t referencePayloadNr);
 #endif /* HEADERS_PACKAGEBUFFER_H_ */
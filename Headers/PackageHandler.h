@@ -68,6 +68,7 @@ typedef enum ePackType
 	PACK_TYPE_REC_ACKNOWLEDGE = 0x02,
 	PACK_TYPE_NETWORK_TEST_PACKAGE_FIRST = 0x03,
 	PACK_TYPE_NETWORK_TEST_PACKAGE_SECOND = 0x04,
+	PACK_TYPE_PARITY_PACKAGE = 0x05,
 } tPackType;
 
 
@@ -95,6 +96,8 @@ typedef struct sWirelessPackage
 	/* internal information, needed for (re)sending package */
 	uint8_t receivedModemNr;
 	bool panicMode; //This boolean is transmitted inside the devNum Variable!
+	uint8_t sendAttempt; //1 = first send, incremented with every resend. Used by the routing, not transmitted
+	TickType_t tickTimeQueued; //when the package was put into the queue to the network handler (QoS queueing delay), not transmitted
 //	uint8_t currentPrioConnection;
 //	int8_t sendAttemptsLeftPerWirelessConnection[NUMBER_OF_UARTS];
 //	uint16_t timestampFirstSendAttempt;
@@ -126,6 +129,19 @@ void packageHandler_TaskEntry(void* p);
 */
 void packageHandler_TaskInit(void);
 
+/*!
+* \fn void packageHandler_run(void)
+* \brief One cycle of the package handler: sends packages byte wise to the wireless byte queues and
+* assembles packages from received wireless bytes.
+*/
+void packageHandler_run(void);
+
+/*!
+* \fn void packageHandler_notify(void)
+* \brief Wakes up the package handler task when EVENT_DRIVEN_TASKS is configured. Called by the tasks which put work into its queues.
+*/
+void packageHandler_notify(void);
+
 /*!
 * \fn ByseType_t popAssembledPackFromQueue(tUartNr uartNr, tWirelessPackage *pPackage)
 * \brief Stores a single byte from the selected queue in pData.
@@ -171,5 +187,23 @@ BaseType_t pushToPacksToDisassembleQueue(tUartNr wlConn, tWirelessPackage* pPack
 */
 uint16_t freeSpaceInPackagesToDisassembleQueue(tUartNr wlConn);
 
+/*!
+* \fn uint32_t numberOfBytesInPacksToDisassembleQueue(tUartNr wlConn)
+* \brief Returns the number of bytes of the packages which are routed to this link, but not in the TX byte queue yet
+* \param wlConn: WL conn where the packages will be transmitted to.
+* \return Bytes waiting in this queue
+*/
+uint32_t numberOfBytesInPacksToDisassembleQueue(tUartNr wlConn);
+
+/*!
+* \fn uint16_t packageHandler_getWirelessFrameSize(tWirelessPackage* pPackage)
+* \brief Number of bytes the package occupies on the wireless UART (before Golay encoding):
+*  PACK_START, header, payload and CRC including the PACK_REP replacements, plus the fill bytes at the end.
+*  The header fields and CRCs are taken as stored in the package (set when it was sent or received).
+* \param pPackage: the package
+* \return size of the frame in bytes
+*/
+uint16_t packageHandler_getWirelessFrameSize(tWirelessPackage* pPackage);
+
 
 #endif /* HEADERS_PACKAGEHANDLER_H_ */
@@ -0,0 +1,139 @@
+/*
+ * ParityFec.h
+ * Forward error correction with systematic Reed-Solomon erasure coding over GF(256).
+ * The sender sends a group of data packages unchanged plus one or more parity packages.
+ * As long as no more data packages of the group are lost than parity packages arrive, the receiver
+ * rebuilds the lost ones without waiting for a resend.
+ *
+ * The parity rows are a Cauchy matrix, scaled so that the first row is all ones: with one parity
+ * package per group, the parity is the XOR of the data payloads.
+ * Every data package is coded as the symbol { payloadSize (2 bytes), payload ... } padded with zeros.
+ *
+ * Data packages carry the payloadNr of the first package of their group in packNr.
+ * The parity packages carry the same packNr, the payloadNr of the last package of the group
+ * and the payload { groupSize, parity row, coded symbol ... }
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HEADERS_PARITYFEC_H_
+#define HEADERS_PARITYFEC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "PackageHandler.h"
+#include "PackageBuffer.h" /* payloadNr comparison */
+#include "FRTOS.h"
+
+/*! \def FEC_MAX_GROUP_SIZE
+*  \brief Maximal number of data packages protected by the parity packages of one group
+*/
+#define FEC_MAX_GROUP_SIZE					16
+
+/*! \def FEC_MAX_PARITY_PACKS
+*  \brief Maximal number of parity packages per group = maximal number of lost data packages which can be rebuilt
+*/
+#define FEC_MAX_PARITY_PACKS				3
+
+/*! \def FEC_PARITY_HEADER_SIZE
+*  \brief Number of bytes in front of the coded symbol in the parity package (group size and parity row)
+*/
+#define FEC_PARITY_HEADER_SIZE				2
+
+/*! \def FEC_SYMBOL_SIZE
+*  \brief Maximal size of a coded symbol, so that the parity package does not get bigger than PACKAGE_MAX_PAYLOAD_SIZE
+*/
+#define FEC_SYMBOL_SIZE						(PACKAGE_MAX_PAYLOAD_SIZE - FEC_PARITY_HEADER_SIZE)
+
+/*! \def FEC_MAX_DATA_PAYLOAD_SIZE
+*  \brief Maximal payload of a data package when FEC is used (the symbol also holds the payloadSize)
+*/
+#define FEC_MAX_DATA_PAYLOAD_SIZE			(FEC_SYMBOL_SIZE - sizeof(uint16_t))
+
+/*! \def FEC_NOF_DECODER_GROUPS
+*  \brief Number of groups per device which the receiver collects at the same time
+*/
+#define FEC_NOF_DECODER_GROUPS				3
+
+typedef struct sFecEncoder
+{
+	uint8_t parity[FEC_MAX_PARITY_PACKS][FEC_SYMBOL_SIZE];	// coded symbols of the current group
+	uint16_t maxSymbolSize;									// size of the biggest symbol of the current group
+	uint16_t firstPayloadNr;								// payloadNr of the first package of the current group
+	uint8_t groupSize;										// number of data packages in a complete group
+	uint8_t nofParityPacks;									// number of parity packages sent for the current group
+	uint8_t nofPacks;										// number of data packages in the current group
+	uint8_t nofParityPacksSent;								// parity packages of the current group which are already generated
+	TickType_t tickTimeLastPackAdded;						// to send the parity of an incomplete group when no more data arrives
+} tFecEncoder;
+
+typedef struct sFecDecoderGroup
+{
+	uint8_t syndrome[FEC_MAX_PARITY_PACKS][FEC_SYMBOL_SIZE];	// received parity plus the coded received data, per parity row
+	uint16_t maxSymbolSize;										// size of the biggest symbol received for this group
+	uint16_t firstPayloadNr;									// payloadNr of the first package of this group
+	uint32_t receivedMask;										// bit x is set if the package firstPayloadNr + x was received
+	uint8_t nofReceived;										// number of bits set in receivedMask
+	uint8_t groupSize;											// known after a parity package was received
+	uint8_t parityReceivedMask;									// bit x is set if the parity package of row x was received
+	uint8_t nofParityReceived;									// number of bits set in parityReceivedMask
+	bool inUse;
+} tFecDecoderGroup;
+
+typedef struct sFecDecoder
+{
+	tFecDecoderGroup group[FEC_NOF_DECODER_GROUPS];
+} tFecDecoder;
+
+
+/*!
+* \fn void parityFec_initEncoder(tFecEncoder* encoder)
+* \brief Initializes the encoder fields (and the GF(256) tables on the first call)
+*/
+void parityFec_initEncoder(tFecEncoder* encoder);
+
+/*!
+* \fn void parityFec_initDecoder(tFecDecoder* decoder)
+* \brief Initializes the decoder fields (and the GF(256) tables on the first call)
+*/
+void parityFec_initDecoder(tFecDecoder* decoder);
+
+/*!
+* \fn void parityFec_addDataPackage(tFecEncoder* encoder, tWirelessPackage* pPackage, uint8_t groupSize, uint8_t nofParityPacks)
+* \brief Adds a newly generated data package to the current group and stores the first payloadNr of the group in its packNr.
+*  Needs to be called before the package is copied into the send buffer.
+* \param groupSize, nofParityPacks: size of the group and its number of parity packages, only used when a new group starts
+*/
+void parityFec_addDataPackage(tFecEncoder* encoder, tWirelessPackage* pPackage, uint8_t groupSize, uint8_t nofParityPacks);
+
+/*!
+* \fn bool parityFec_generateParityPackage(tFecEncoder* encoder, uint16_t timeoutTicks, tWirelessPackage* pPackage)
+* \brief Generates the next parity package of the current group if the group is complete or if no data package
+*  was added for timeoutTicks. After the last parity package of the group, the encoder starts a new group.
+*  The payload needs to be freed after usage!
+* \return true if a parity package was generated
+*/
+bool parityFec_generateParityPackage(tFecEncoder* encoder, uint16_t timeoutTicks, tWirelessPackage* pPackage);
+
+/*!
+* \fn void parityFec_receivedDataPackage(tFecDecoder* decoder, tWirelessPackage* pPackage)
+* \brief Adds the payload of a received data package to its group. Packages received twice are ignored.
+*/
+void parityFec_receivedDataPackage(tFecDecoder* decoder, tWirelessPackage* pPackage);
+
+/*!
+* \fn void parityFec_receivedParityPackage(tFecDecoder* decoder, tWirelessPackage* pPackage)
+* \brief Adds the payload of a received parity package to its group. Packages received twice are ignored.
+*/
+void parityFec_receivedParityPackage(tFecDecoder* decoder, tWirelessPackage* pPackage);
+
+/*!
+* \fn bool parityFec_rebuildLostPackage(tFecDecoder* decoder, uint16_t firstPayloadNr, tWirelessPackage* pPackage)
+* \brief Rebuilds one lost data package of the group firstPayloadNr if at least as many parity packages as lost
+*  data packages were received. Call it again until it returns false to rebuild all lost packages.
+*  The payload needs to be freed after usage!
+* \return true if a package was rebuilt
+*/
+bool parityFec_rebuildLostPackage(tFecDecoder* decoder, uint16_t firstPayloadNr, tWirelessPackage* pPackage);
+
+#endif /* HEADERS_PARITYFEC_H_ */
@@ -0,0 +1,19 @@
+/*
+ * Pipeline.h
+ * Runs the SPI, package, network and transport handler as direct function calls within one task
+ * (RUN_TO_COMPLETION_PIPELINE).
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HEADERS_PIPELINE_H_
+#define HEADERS_PIPELINE_H_
+
+/*!
+* \fn void pipeline_TaskEntry(void* p)
+* \brief Task initializes the MAX14830 and then runs the whole transmit and receive chain every SPI_HANDLER_TASK_INTERVAL:
+* SPI read -> package handler -> network handler -> transport handler -> network handler -> package handler -> SPI write
+*/
+void pipeline_TaskEntry(void* p);
+
+#endif /* HEADERS_PIPELINE_H_ */
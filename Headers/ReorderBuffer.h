@@ -0,0 +1,96 @@
+/*
+ * ReorderBuffer.h
+ * Ring buffer for the payload reordering on the receive side.
+ * Packages are stored at the index (payloadNr % REORDER_BUFFER_SIZE), so the next package
+ * in order is found without searching the buffer.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HEADERS_REORDERBUFFER_H_
+#define HEADERS_REORDERBUFFER_H_
+
+#include <stdint.h>
+#include "PackageHandler.h"
+#include "PackageBuffer.h" /* payloadNr comparison */
+#include "FRTOS.h"
+
+/*! \def REORDER_BUFFER_SIZE
+*  \brief Number of packages which can be stored ahead of the last package in order.
+*  Needs to be a power of two so that the ring index stays valid when the payloadNr wraps around.
+*/
+#define REORDER_BUFFER_SIZE					128
+
+typedef struct sReorderBuffer
+{
+	tWirelessPackage packageArray[REORDER_BUFFER_SIZE];				// package with payloadNr x is stored at index x % REORDER_BUFFER_SIZE
+	bool indexIsEmpty[REORDER_BUFFER_SIZE];							// indicates if a entry in the buffer is free or occupied
+	TickType_t tickTimestampBufferInsertion[REORDER_BUFFER_SIZE];	// Timestamp in ticks at the moment the Package gets inserted into the buffer
+	size_t count;													// number of packages in the buffer
+	uint16_t payloadNrLastInOrder;									// The payloadNR of the last package which was pushed out completely or skipped
+	uint16_t nofBytesSentOfNextPayload;							// How many bytes of the next package in order were already pushed out
+} tReorderBuffer;
+
+typedef enum eReorderBufferPutResult
+{
+	REORDER_BUFFER_PUT_STORED = 0,			// package stored or already received, can be acknowledged
+	REORDER_BUFFER_PUT_DROPPED,				// package too far ahead of the stored ones, not acknowledged so the sender resends it
+	REORDER_BUFFER_PUT_NO_MEMORY			// no memory available, try again in the next cycle
+} tReorderBufferPutResult;
+
+
+/*!
+* \fn void reorderBuffer_init(tReorderBuffer* buffer)
+* \brief Initializes the buffer fields
+*/
+void reorderBuffer_init(tReorderBuffer* buffer);
+
+/*!
+* \fn void reorderBuffer_free(tReorderBuffer* buffer, uint16_t payloadNrLastInOrder)
+* \brief Frees all packages in the buffer (also their payloads) and restarts the ordering after payloadNrLastInOrder
+*/
+void reorderBuffer_free(tReorderBuffer* buffer, uint16_t payloadNrLastInOrder);
+
+/*!
+* \fn tReorderBufferPutResult reorderBuffer_put(tReorderBuffer* buffer, tWirelessPackage* packet)
+* \brief Copies the packet into the buffer if it is new.
+*  Packages which are already in the buffer or older than the last package in order are ignored.
+*  A package too far ahead of the last package in order restarts the ordering before it if the buffer is empty,
+*  otherwise it is dropped until the timeout has pushed out the stored packages.
+*/
+tReorderBufferPutResult reorderBuffer_put(tReorderBuffer* buffer, tWirelessPackage* packet);
+
+/*!
+* \fn bool reorderBuffer_getNextOrderedPayload(tReorderBuffer* buffer, uint8_t** payload, uint16_t* nofBytes)
+* \brief Returns the bytes of the next payload in order which were not pushed out yet. The package stays in the buffer
+*  until it is consumed with reorderBuffer_consumeOrderedPayload().
+* \param payload: Pointer to the first byte which was not pushed out yet
+* \param nofBytes: Number of bytes left in this payload
+* \return true if the next package in order is in the buffer
+*/
+bool reorderBuffer_getNextOrderedPayload(tReorderBuffer* buffer, uint8_t** payload, uint16_t* nofBytes);
+
+/*!
+* \fn bool reorderBuffer_consumeOrderedPayload(tReorderBuffer* buffer, uint16_t nofBytes)
+* \brief Marks nofBytes of the next payload in order as pushed out. When the whole payload is pushed out,
+*  the package is freed and the next package in order becomes available.
+* \return true if the payload was pushed out completely
+*/
+bool reorderBuffer_consumeOrderedPayload(tReorderBuffer* buffer, uint16_t nofBytes);
+
+/*!
+* \fn bool reorderBuffer_skipToPackageOlderThanTimeout(tReorderBuffer* buffer, uint16_t timeOutTicks, tWirelessPackage* packet)
+* \brief If the next package in order is missing and a package ahead of it was longer in the buffer than timeOutTicks,
+*  the gap is given up: the package is taken out of the buffer and the ordering continues after it.
+*  Needs to be freed after usage!
+* \return true if a package was taken out of the buffer
+*/
+bool reorderBuffer_skipToPackageOlderThanTimeout(tReorderBuffer* buffer, uint16_t timeOutTicks, tWirelessPackage* packet);
+
+/*!
+* \fn uint16_t reorderBuffer_getCurrentPayloadNR(tReorderBuffer* buffer)
+* \brief returns the payloadNr of the last package which was pushed out in order
+*/
+uint16_t reorderBuffer_getCurrentPayloadNR(tReorderBuffer* buffer);
+
+#endif /* HEADERS_REORDERBUFFER_H_ */
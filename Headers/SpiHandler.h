@@ -140,6 +140,31 @@ void spiHandler_TaskEntry(void* p);
 */
 void spiHandler_TaskInit(void);
 
+/*!
+* \fn void spiHandler_initMax14830(void)
+* \brief Resets both MAX14830 and configures baud rates, clock source and word length.
+* Needs to be called from a task because it waits for the MAX14830 to get ready.
+*/
+void spiHandler_initMax14830(void);
+
+/*!
+* \fn void spiHandler_readHwBufs(void)
+* \brief Reads the received bytes of all UARTs on both MAX14830 into the RX byte queues
+*/
+void spiHandler_readHwBufs(void);
+
+/*!
+* \fn void spiHandler_writeHwBufs(void)
+* \brief Writes the bytes of the TX byte queues of all UARTs on both MAX14830 into the HW buffers
+*/
+void spiHandler_writeHwBufs(void);
+
+/*!
+* \fn void spiHandler_notify(void)
+* \brief Wakes up the SPI handler task when EVENT_DRIVEN_TASKS is configured. Called by the tasks which put work into its queues.
+*/
+void spiHandler_notify(void);
+
 /*!
 * \fn ByseType_t pushToByteQueue(tSpiSlaves spiSlave, tUartNr uartNr, uint8_t *pData)
 * \brief Stores pData in queue
@@ -186,4 +211,14 @@ uint16_t numberOfBytesInTxByteQueue(tSpiSlaves spiSlave, tUartNr uartNr);
 */
 uint16_t freeSpaceInTxByteQueue(tSpiSlaves spiSlave, tUartNr uartNr);
 
+/*!
+* \fn uint16_t numberOfBytesWaitingForTx(tSpiSlaves spiSlave, tUartNr uartNr)
+* \brief Returns the transmit backlog of a UART: the bytes in the TX byte queue plus the bytes in the MAX14830 TX FIFO.
+* The FIFO level is the one read at the last write to the FIFO, reduced by the bytes the UART sent out since then.
+* \param uartNr: UART number the bytes should be transmitted to.
+* \param spiSlave: spiSlave byte should be sent to.
+* \return Number of bytes waiting to be sent out
+*/
+uint16_t numberOfBytesWaitingForTx(tSpiSlaves spiSlave, tUartNr uartNr);
+
 #endif
@@ -18,6 +18,7 @@ void SysInit_TaskEntry(void* param);
 #define THROUGHPUT_PRINTOUT_STACK_SIZE	(2000/sizeof(StackType_t))
 #define TESTBENCHMASTER_STACK_SIZE		(2000/sizeof(StackType_t))
 #define LOGGER_STACK_SIZE				(2000/sizeof(StackType_t))
+#define PIPELINE_STACK_SIZE				(3000/sizeof(StackType_t))
 #define BLINKY_STACK_SIZE				(400/sizeof(StackType_t))
 
 #endif
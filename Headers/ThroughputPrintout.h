@@ -25,6 +25,19 @@ extern long unsigned int numberOfDroppedBytes[NOF_SPI_SLAVES][NUMBER_OF_UARTS];
 extern long unsigned int numberOfInvalidPackages[NUMBER_OF_UARTS];
 extern long unsigned int numberOfRxBytesHwBuf[NOF_SPI_SLAVES][NUMBER_OF_UARTS];
 extern long unsigned int numberOfTxBytesHwBuf[NOF_SPI_SLAVES][NUMBER_OF_UARTS];
+extern long unsigned int numberOfPacksInReorderBuffer[NUMBER_OF_UARTS];
+extern long unsigned int maxNumberOfPacksInReorderBuffer[NUMBER_OF_UARTS];
+extern long unsigned int numberOfRebuiltPacks[NUMBER_OF_UARTS];
+extern long unsigned int numberOfSuppressedDuplicates[NUMBER_OF_UARTS];
+extern long unsigned int numberOfDispatchStalls[NUMBER_OF_UARTS];
+extern long unsigned int numberOfProbeBytesSaved[NUMBER_OF_UARTS];
+extern long unsigned int numberOfLinkStateTransitions[NUMBER_OF_UARTS];
+extern long unsigned int numberOfLinkRoutingTransitions[NUMBER_OF_UARTS];
+extern long unsigned int numberOfGolayDecodedWords[NUMBER_OF_UARTS];
+extern long unsigned int numberOfGolayCorrectedWords[NUMBER_OF_UARTS];
+extern long unsigned int queueingDelaySum[NUMBER_OF_UARTS];
+extern long unsigned int numberOfQueueingDelaySamples[NUMBER_OF_UARTS];
+extern long unsigned int maxQueueingDelay[NUMBER_OF_UARTS];
 
 void throughputPrintout_TaskEntry(void* p);
 
@@ -28,6 +28,32 @@
 */
 #define QUEUE_NUM_OF_RECEIVED_PAYLOAD_PACKS			25
 
+/*! \def CONGESTION_WINDOW_INITIAL
+*  \brief Number of unacknowledged data packages a device may have in flight after startup
+*/
+#define CONGESTION_WINDOW_INITIAL					2
+
+/*! \def CONGESTION_WINDOW_MIN
+*  \brief The sending window of a device never gets smaller than this number of packages
+*/
+#define CONGESTION_WINDOW_MIN						1
+
+/*! \def BYTE_ARRIVAL_RATE_MEASURE_INTERVAL
+*  \brief Interval in ms over which the arrival rate of device bytes is measured (adaptive packet size)
+*/
+#define BYTE_ARRIVAL_RATE_MEASURE_INTERVAL			50
+
+/*! \def ADAPTIVE_PACKET_SIZE_LINK_USAGE
+*  \brief Percentage of the wireless bandwidth which payload and header bytes may use before the
+*  adaptive packet size grows to save header overhead
+*/
+#define ADAPTIVE_PACKET_SIZE_LINK_USAGE				80
+
+/*! \def FEC_ADAPTIVE_LOSS_FACTOR
+*  \brief With adaptive FEC, parity packages are sent for this multiple of the measured packet loss (covers loss bursts)
+*/
+#define FEC_ADAPTIVE_LOSS_FACTOR					2
+
 /*!
 * \fn void networkHandler_TaskEntry(void)
 * \brief Task generates packages from received bytes (received on device side) and sends those down to
@@ -44,6 +70,19 @@ void transportHandler_TaskEntry(void* p);
 */
 void transportHandler_TaskInit(void);
 
+/*!
+* \fn void transportHandler_run(void)
+* \brief One cycle of the transport handler: generates, resends and acknowledges packages and pushes
+* received payloads in order out on the device side.
+*/
+void transportHandler_run(void);
+
+/*!
+* \fn void transportHandler_notify(void)
+* \brief Wakes up the transport handler task when EVENT_DRIVEN_TASKS is configured. Called by the tasks which put work into its queues.
+*/
+void transportHandler_notify(void);
+
 /*!
 * \fn ByseType_t popToReadyToSendPackFromQueue(tUartNr uartNr, tWirelessPackage* pPackage)
 * \brief Pops a package from queue
@@ -3,18 +3,26 @@
 #include <stdlib.h> //atoi()
 #include <stdbool.h>
 #include "Platform.h"
+#include "ParityFec.h" /* FEC_MAX_GROUP_SIZE */
+#include "NetworkMetrics.h" /* PROBE_TRAIN_MAX_LENGTH */
+#include "Shell.h" /* pushMsgToShellQueue() */
 
 #define TEMP_CSV_SIZE 50
 #define DEFAULT_CSV_STRING "0, 0, 0, 0"
 #define DEFAULT_BOOL 0
 #define DEFAULT_INT 1000
 
+/* Q_THRESHOLD_ENTER and Q_THRESHOLD_EXIT used if the configured thresholds are not ordered */
+static const int defaultQthresholdEnter[NOF_ROUTING_STATES] = {300, 50, 20, 0};
+static const int defaultQthresholdExit[NOF_ROUTING_STATES] = {270, 45, 18, 0};
+
 
 /* prototypes */
 void csvToInt(char inputString[], int outputArray[]);
 void csvToBool(char inputString[], bool outputArray[]);
 void setDefaultConfigValues(void);
 void validateSwConfiguration(void);
+static void validateQthresholds(void);
 
 /* global variables */
 Configuration config;
@@ -138,6 +146,25 @@ bool readConfig(void)
     numberOfCharsCopied = MINI_ini_gets("ConnectionConfiguration", "SECOND_FALLBACK_WIRELESS_LINK",  DEFAULT_CSV_STRING, copiedCsv, TEMP_CSV_SIZE, "serialSwitch_Config.ini");
   	csvToInt(copiedCsv, config.secondFallbackWirelessLink);
 
+  	/* QOS_CLASS */
+    numberOfCharsCopied = MINI_ini_gets("ConnectionConfiguration", "QOS_CLASS",  DEFAULT_CSV_STRING, copiedCsv, TEMP_CSV_SIZE, "serialSwitch_Config.ini");
+  	csvToInt(copiedCsv, config.QosClass);
+  	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+  	{
+  		if(config.QosClass[i] != QOS_CLASS_STRICT_PRIORITY)
+  		{
+  			config.QosClass[i] = QOS_CLASS_WEIGHTED_FAIR; /* QOS_CLASS_WEIGHTED_FAIR if parameter faulty */
+  		}
+  	}
+
+  	/* QOS_WEIGHT */
+    numberOfCharsCopied = MINI_ini_gets("ConnectionConfiguration", "QOS_WEIGHT",  DEFAULT_CSV_STRING, copiedCsv, TEMP_CSV_SIZE, "serialSwitch_Config.ini");
+  	csvToInt(copiedCsv, config.QosWeight);
+  	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+  	{
+  		config.QosWeight[i] = UTIL1_constrain(config.QosWeight[i], 1, 100);
+  	}
+
   	/* -------- TransmissionConfiguration -------- */
   	/* ResendDelayWirelessConn */
   	config.ResendDelayWirelessConn = MINI_ini_getl("TransmissionConfiguration", "RESEND_DELAY_WIRELESS_CONN",  DEFAULT_INT, "serialSwitch_Config.ini");
@@ -149,6 +176,10 @@ bool readConfig(void)
   	numberOfCharsCopied = MINI_ini_gets("TransmissionConfiguration", "USUAL_PACKET_SIZE_DEVICE_CONN",  DEFAULT_CSV_STRING, copiedCsv, TEMP_CSV_SIZE, "serialSwitch_Config.ini");
   	csvToInt(copiedCsv, config.UsualPacketSizeDeviceConn);
 
+  	/* ADAPTIVE_PACKET_SIZE_DEVICE_CONN */
+  	numberOfCharsCopied = MINI_ini_gets("TransmissionConfiguration", "ADAPTIVE_PACKET_SIZE_DEVICE_CONN",  DEFAULT_CSV_STRING, copiedCsv, TEMP_CSV_SIZE, "serialSwitch_Config.ini");
+  	csvToBool(copiedCsv, config.AdaptivePacketSizeDeviceConn);
+
   	/* PACKAGE_GEN_MAX_TIMEOUT */
   	numberOfCharsCopied = MINI_ini_gets("TransmissionConfiguration", "PACKAGE_GEN_MAX_TIMEOUT",  DEFAULT_CSV_STRING, copiedCsv, TEMP_CSV_SIZE, "serialSwitch_Config.ini");
   	csvToInt(copiedCsv, config.PackageGenMaxTimeout);
@@ -175,6 +206,13 @@ bool readConfig(void)
 		case ROUTING_METHODE_VARIANT_2:
 		case ROUTING_METHODE_VARIANT_3:
 			break; /* no action when config parameter set right */
+		case ROUTING_METHODE_VARIANT_4:
+		case ROUTING_METHODE_VARIANT_5:
+			if(config.RoutingMethode != ROUTING_METHODE_METRICS)
+			{
+				config.RoutingMethodeVariant = ROUTING_METHODE_VARIANT_1; /* striping needs the bandwidth metric */
+			}
+			break;
 		default:
 			config.RoutingMethodeVariant = ROUTING_METHODE_VARIANT_1; /* ROUTING_METHODE_VARIANT_1 if parameter faulty */
   	}
@@ -183,14 +221,78 @@ bool readConfig(void)
   	numberOfCharsCopied = MINI_ini_gets("TransmissionConfiguration", "USE_PROBING_PACKS",  DEFAULT_CSV_STRING, copiedCsv, TEMP_CSV_SIZE, "serialSwitch_Config.ini");
   	csvToBool(copiedCsv, config.UseProbingPacksWlConn);
 
+  	/* PROBE_TRAIN_LENGTH */
+  	numberOfCharsCopied = MINI_ini_gets("TransmissionConfiguration", "PROBE_TRAIN_LENGTH",  DEFAULT_CSV_STRING, copiedCsv, TEMP_CSV_SIZE, "serialSwitch_Config.ini");
+  	csvToInt(copiedCsv, config.ProbeTrainLengthWlConn);
+  	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+  	{
+  		config.ProbeTrainLengthWlConn[i] = UTIL1_constrain(config.ProbeTrainLengthWlConn[i], 2, PROBE_TRAIN_MAX_LENGTH);
+  	}
+
+  	/* USE_PASSIVE_METRICS  */
+  	numberOfCharsCopied = MINI_ini_gets("TransmissionConfiguration", "USE_PASSIVE_METRICS",  DEFAULT_CSV_STRING, copiedCsv, TEMP_CSV_SIZE, "serialSwitch_Config.ini");
+  	csvToBool(copiedCsv, config.UsePassiveMetricsWlConn);
+
   	/* COST_PER_PACKET_METRIC  */
   	numberOfCharsCopied = MINI_ini_gets("TransmissionConfiguration", "COST_PER_PACKET_METRIC",  DEFAULT_CSV_STRING, copiedCsv, TEMP_CSV_SIZE, "serialSwitch_Config.ini");
   	csvToInt(copiedCsv, config.CostPerPacketMetric);
 
+  	/* RTT_FILTER_PARAM */
+  	config.RttFilterParam = MINI_ini_getl("TransmissionConfiguration", "RTT_FILTER_PARAM",  DEFAULT_INT, "serialSwitch_Config.ini");
+  	config.RttFilterParam = UTIL1_constrain(config.RttFilterParam, 0, 1000);
+
+  	/* SBPP_FILTER_PARAM */
+  	config.SbppFilterParam = MINI_ini_getl("TransmissionConfiguration", "SBPP_FILTER_PARAM",  DEFAULT_INT, "serialSwitch_Config.ini");
+  	config.SbppFilterParam = UTIL1_constrain(config.SbppFilterParam, 0, 1000);
+
+  	/* PLR_HALF_LIFE */
+  	config.PlrHalfLife = MINI_ini_getl("TransmissionConfiguration", "PLR_HALF_LIFE",  DEFAULT_INT, "serialSwitch_Config.ini");
+  	config.PlrHalfLife = UTIL1_constrain(config.PlrHalfLife, 1, 60000);
+
+  	/* TREND_HORIZON */
+  	config.TrendHorizon = MINI_ini_getl("TransmissionConfiguration", "TREND_HORIZON",  DEFAULT_INT, "serialSwitch_Config.ini");
+  	config.TrendHorizon = UTIL1_constrain(config.TrendHorizon, 0, 60000);
+
+  	/* Q_THRESHOLD_ENTER */
+  	numberOfCharsCopied = MINI_ini_gets("TransmissionConfiguration", "Q_THRESHOLD_ENTER",  DEFAULT_CSV_STRING, copiedCsv, TEMP_CSV_SIZE, "serialSwitch_Config.ini");
+  	csvToInt(copiedCsv, config.QthresholdEnter);
+
+  	/* Q_THRESHOLD_EXIT */
+  	numberOfCharsCopied = MINI_ini_gets("TransmissionConfiguration", "Q_THRESHOLD_EXIT",  DEFAULT_CSV_STRING, copiedCsv, TEMP_CSV_SIZE, "serialSwitch_Config.ini");
+  	csvToInt(copiedCsv, config.QthresholdExit);
+  	for(int i = 0 ; i < NOF_ROUTING_STATES ; i++)
+  	{
+  		config.QthresholdExit[i] = UTIL1_constrain(config.QthresholdExit[i], 0, config.QthresholdEnter[i]); /* no hysteresis if the exit threshold is too high */
+  	}
+
+  	/* ROUTING_STATE_MIN_DWELL */
+  	numberOfCharsCopied = MINI_ini_gets("TransmissionConfiguration", "ROUTING_STATE_MIN_DWELL",  DEFAULT_CSV_STRING, copiedCsv, TEMP_CSV_SIZE, "serialSwitch_Config.ini");
+  	csvToInt(copiedCsv, config.RoutingStateMinDwell);
+
   	/* USE_GOLAY_ERROR_CORRECTING_CODE */
   	numberOfCharsCopied = MINI_ini_gets("TransmissionConfiguration", "USE_GOLAY_ERROR_CORRECTING_CODE",  DEFAULT_CSV_STRING, copiedCsv, TEMP_CSV_SIZE, "serialSwitch_Config.ini");
   	csvToBool(copiedCsv, config.UseGolayPerWlConn);
 
+  	/* CONGESTION_WINDOW_MAX */
+  	numberOfCharsCopied = MINI_ini_gets("TransmissionConfiguration", "CONGESTION_WINDOW_MAX",  DEFAULT_CSV_STRING, copiedCsv, TEMP_CSV_SIZE, "serialSwitch_Config.ini");
+  	csvToInt(copiedCsv, config.CongestionWindowMaxDeviceConn);
+
+  	/* FEC_PARITY_GROUP_SIZE */
+  	numberOfCharsCopied = MINI_ini_gets("TransmissionConfiguration", "FEC_PARITY_GROUP_SIZE",  DEFAULT_CSV_STRING, copiedCsv, TEMP_CSV_SIZE, "serialSwitch_Config.ini");
+  	csvToInt(copiedCsv, config.FecParityGroupSize);
+  	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+  	{
+  		config.FecParityGroupSize[i] = UTIL1_constrain(config.FecParityGroupSize[i], 0, FEC_MAX_GROUP_SIZE);
+  	}
+
+  	/* FEC_PARITY_PACKS */
+  	numberOfCharsCopied = MINI_ini_gets("TransmissionConfiguration", "FEC_PARITY_PACKS",  DEFAULT_CSV_STRING, copiedCsv, TEMP_CSV_SIZE, "serialSwitch_Config.ini");
+  	csvToInt(copiedCsv, config.FecParityPacks);
+  	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+  	{
+  		config.FecParityPacks[i] = UTIL1_constrain(config.FecParityPacks[i], 0, FEC_MAX_PARITY_PACKS);
+  	}
+
   	/* -------- SoftwareConfiguration -------- */
   	/* TEST_HW_LOOPBACK_ONLY */
   	config.TestHwLoopbackOnly = MINI_ini_getbool("SoftwareConfiguration", "TEST_HW_LOOPBACK_ONLY",  DEFAULT_BOOL, "serialSwitch_Config.ini");
@@ -274,6 +376,15 @@ bool readConfig(void)
 	/* LOGGER_TASK_INTERVAL */
 	config.LoggerTaskInterval = MINI_ini_getl("SoftwareConfiguration", "LOGGER_TASK_INTERVAL",  DEFAULT_INT, "serialSwitch_Config.ini");
 
+	/* EVENT_DRIVEN_TASKS */
+	config.EventDrivenTasks = MINI_ini_getbool("SoftwareConfiguration", "EVENT_DRIVEN_TASKS",  DEFAULT_BOOL, "serialSwitch_Config.ini");
+
+	/* EVENT_DRIVEN_FALLBACK_INTERVAL */
+	config.EventDrivenFallbackInterval = MINI_ini_getl("SoftwareConfiguration", "EVENT_DRIVEN_FALLBACK_INTERVAL",  DEFAULT_INT, "serialSwitch_Config.ini");
+
+	/* RUN_TO_COMPLETION_PIPELINE */
+	config.RunToCompletionPipeline = MINI_ini_getbool("SoftwareConfiguration", "RUN_TO_COMPLETION_PIPELINE",  DEFAULT_BOOL, "serialSwitch_Config.ini");
+
 	validateSwConfiguration();
 
   	return true;
@@ -296,4 +407,40 @@ void validateSwConfiguration(void)
 	UTIL1_constrain(config.LoggerTaskInterval, 1, 1000); /* 1ms...1sec */
 	UTIL1_constrain(config.ThroughputPrintoutTaskInterval_s, 1, 1000); /* 1sec...1000sec */
 	UTIL1_constrain(config.ToggleGreenLedInterval, 1, 1000); /* 1ms...1sec */
+	config.EventDrivenFallbackInterval = UTIL1_constrain(config.EventDrivenFallbackInterval, 1, 1000); /* 1ms...1sec */
+
+	/* the modem simulation of the test bench delays the network handler task, which does not exist in the single task pipeline */
+	if(config.EnableRoutingAlgorithmTestBench != TESTBENCH_OFF)
+	{
+		config.RunToCompletionPipeline = false;
+	}
+
+	validateQthresholds(); /* needs GenerateDebugOutput for the warning */
+}
+
+/*!
+* \fn static void validateQthresholds(void)
+* \brief The link states of the routing rely on Q_THRESHOLD_ENTER decreasing from the single link state down to the
+*  redundant all links state (and not below the panic state). Otherwise, the default thresholds are used.
+*/
+static void validateQthresholds(void)
+{
+	bool ordered = (config.QthresholdEnter[ROUTING_STATE_REDUNDANT_ALL_LINKS] >= config.QthresholdEnter[ROUTING_STATE_PANIC]);
+
+	for(int i = ROUTING_STATE_SINGLE_LINK ; i < ROUTING_STATE_REDUNDANT_ALL_LINKS ; i++)
+	{
+		if(config.QthresholdEnter[i] <= config.QthresholdEnter[i + 1])
+		{
+			ordered = false;
+		}
+	}
+	if(!ordered)
+	{
+		for(int i = 0 ; i < NOF_ROUTING_STATES ; i++)
+		{
+			config.QthresholdEnter[i] = defaultQthresholdEnter[i];
+			config.QthresholdExit[i] = defaultQthresholdExit[i];
+		}
+		pushMsgToShellQueue("Warning: Q_THRESHOLD_ENTER needs to decrease from the single link to the redundant all links state, using the default Q thresholds\r\n");
+	}
 }
@@ -0,0 +1,124 @@
+/*
+ * FixedPoint.c
+ * Unsigned Q16.16 fixed-point arithmetic for the network metrics (no float on the K64F hot path).
+ *
+ *  Created on: Oct 19, 2026
+ */
+#include "FixedPoint.h"
+
+/* --------------- prototypes ------------------- */
+static tFixedPoint saturate(uint64_t value);
+
+/*!
+* \fn tFixedPoint fixedPoint_fromInt(uint32_t value)
+* \brief Converts an integer to Q16.16 (saturated)
+*/
+tFixedPoint fixedPoint_fromInt(uint32_t value)
+{
+	return saturate((uint64_t)value << FIXED_POINT_FRACTION_BITS);
+}
+
+/*!
+* \fn tFixedPoint fixedPoint_fromPerMille(uint32_t perMille)
+* \brief Converts a value in per mille (1000 = 1.0) to Q16.16 (saturated)
+*/
+tFixedPoint fixedPoint_fromPerMille(uint32_t perMille)
+{
+	return saturate((((uint64_t)perMille << FIXED_POINT_FRACTION_BITS) + 500) / 1000);
+}
+
+/*!
+* \fn uint16_t fixedPoint_toUint16(tFixedPoint value)
+* \brief Rounds to the nearest integer, saturated to 0xFFFF
+*/
+uint16_t fixedPoint_toUint16(tFixedPoint value)
+{
+	uint32_t rounded = (uint32_t)(((uint64_t)value + (FIXED_POINT_ONE / 2)) >> FIXED_POINT_FRACTION_BITS);
+
+	if(rounded > 0xFFFF)
+	{
+		return 0xFFFF;
+	}
+	return (uint16_t)rounded;
+}
+
+/*!
+* \fn tFixedPoint fixedPoint_add(tFixedPoint a, tFixedPoint b)
+* \brief a + b, saturated
+*/
+tFixedPoint fixedPoint_add(tFixedPoint a, tFixedPoint b)
+{
+	return saturate((uint64_t)a + b);
+}
+
+/*!
+* \fn tFixedPoint fixedPoint_mul(tFixedPoint a, tFixedPoint b)
+* \brief a * b, saturated
+*/
+tFixedPoint fixedPoint_mul(tFixedPoint a, tFixedPoint b)
+{
+	return saturate(((uint64_t)a * b) >> FIXED_POINT_FRACTION_BITS);
+}
+
+/*!
+* \fn tFixedPoint fixedPoint_div(tFixedPoint a, tFixedPoint b)
+* \brief a / b, saturated. Division by 0 returns FIXED_POINT_MAX (0 / 0 returns 0)
+*/
+tFixedPoint fixedPoint_div(tFixedPoint a, tFixedPoint b)
+{
+	if(b == 0)
+	{
+		return (a == 0) ? 0 : FIXED_POINT_MAX;
+	}
+	return saturate(((uint64_t)a << FIXED_POINT_FRACTION_BITS) / b);
+}
+
+/*!
+* \fn tFixedPoint fixedPoint_exponentialFilter(tFixedPoint y, tFixedPoint x, tFixedPoint a)
+* \brief Exponential filter y = a*y + (1-a)*x
+* \param a: filter parameter between 0 and FIXED_POINT_ONE (bigger = slower filter), limited to this range
+* \return the new filtered value
+*/
+tFixedPoint fixedPoint_exponentialFilter(tFixedPoint y, tFixedPoint x, tFixedPoint a)
+{
+	if(a > FIXED_POINT_ONE)
+	{
+		a = FIXED_POINT_ONE;
+	}
+	/* a*y + (1-a)*x never gets bigger than max(x,y), so there is no overflow */
+	return (tFixedPoint)(((uint64_t)a * y + (uint64_t)(FIXED_POINT_ONE - a) * x + (FIXED_POINT_ONE / 2)) >> FIXED_POINT_FRACTION_BITS);
+}
+
+/*!
+* \fn tFixedPoint fixedPoint_pow2Neg(tFixedPoint x)
+* \brief 2^(-x), used as decay factor after x half-lives. The fraction of x is approximated with a
+*  quadratic polynomial (relative error < 0.3 % plus the Q16.16 resolution)
+*/
+tFixedPoint fixedPoint_pow2Neg(tFixedPoint x)
+{
+	uint32_t halvings = x >> FIXED_POINT_FRACTION_BITS;
+	uint64_t fraction = x & (FIXED_POINT_ONE - 1);
+	tFixedPoint result;
+
+	if(halvings >= FIXED_POINT_FRACTION_BITS + 1)
+	{
+		return 0;
+	}
+	/* 2^(-f) = 1 - 0.67157*f + 0.17157*f^2, exact for f = 0, 0.5 and 1 */
+	result = FIXED_POINT_ONE - (tFixedPoint)((44012 * fraction) >> FIXED_POINT_FRACTION_BITS)
+			 + (tFixedPoint)((11244 * fraction * fraction) >> (2 * FIXED_POINT_FRACTION_BITS));
+	return result >> halvings;
+}
+
+/*!
+* \fn static tFixedPoint saturate(uint64_t value)
+* \brief Limits a 64 bit intermediate result to the range of tFixedPoint
+*/
+static tFixedPoint saturate(uint64_t value)
+{
+	if(value > FIXED_POINT_MAX)
+	{
+		return FIXED_POINT_MAX;
+	}
+	return (tFixedPoint)value;
+}
@@ -20,6 +20,7 @@
 #include "PackageHandler.h"
 #include "NetworkMetrics.h"
 #include "TestBenchModemSimulation.h"
+#include "PackageBuffer.h" /* payloadNr comparison */
 
 
 /* global variables, only used in this file */
@@ -30,13 +31,36 @@
 //static volatile bool ackReceived[NUMBER_OF_UARTS];
 //static uint8_t costFunctionPerWlConn[NUMBER_OF_UARTS];
 
+static TaskHandle_t networkHandlerTaskHandle = NULL; /* to wake up the task when there is work in its queues */
+
+/* duplicate suppression: bit (payloadNr % DUPLICATE_WINDOW_SIZE) is set if the data package was passed to the transport handler */
+static uint32_t forwardedPayloadNrBitmap[NUMBER_OF_UARTS][DUPLICATE_WINDOW_SIZE/32];
+static uint16_t tickTimeForwarded[NUMBER_OF_UARTS][DUPLICATE_WINDOW_SIZE];	/* lower 16 bits of the tick count */
+static uint16_t newestForwardedPayloadNr[NUMBER_OF_UARTS];
+static uint8_t sessionNrOfDuplicateWindow[NUMBER_OF_UARTS];
+static bool duplicateWindowValid[NUMBER_OF_UARTS];
+
+/* routing decision of the next generated package per device, kept while the package waits for space on its links */
+static bool linksOfDeferredPackage[NUMBER_OF_UARTS][NUMBER_OF_UARTS];
+static bool deferredPackageRouted[NUMBER_OF_UARTS];
+static uint32_t routingSequenceOfDeferredPackage[NUMBER_OF_UARTS];	/* a newer routing decision routes the deferred package again */
+static bool deferredPackageRoutedByMetrics[NUMBER_OF_UARTS];		/* the links are charged with networkMetrics_chargeLink() when the package is sent */
+
+/* QoS scheduler: bytes every weighted fair device may still send in the current deficit round robin round */
+static uint32_t qosDeficit[NUMBER_OF_UARTS];
+
 /* prototypes of local functions */
 static void initNetworkHandlerQueues(void);
 static void initSempahores(void);
 static bool processAssembledPackage(tUartNr wlConn);
+static bool dispatchGeneratedPackage(tUartNr deviceNr);
+static int8_t qosScheduleNextDevice(bool* deviceDeferred, tWirelessPackage* pNextPackage);
+static void qosPackageDispatched(tUartNr deviceNr, tWirelessPackage* pPackage);
 static bool sendGeneratedWlPackage(tWirelessPackage* pPackage, tUartNr rawDataUartNr);
 static void oneToOnerouting(tUartNr deviceNr, bool* wlConnToUse);
 static bool copyPackage(tWirelessPackage* original, tWirelessPackage* copy);
+static bool isRedundantCopy(tWirelessPackage* pPackage);
+static void markPayloadNrForwarded(tWirelessPackage* pPackage);
 
 
 /*!
@@ -48,98 +72,286 @@ static bool copyPackage(tWirelessPackage* original, tWirelessPackage* copy);
 void networkHandler_TaskEntry(void* p)
 {
 	const TickType_t taskInterval = pdMS_TO_TICKS(config.NetworkHandlerTaskInterval);
-	tWirelessPackage package;
 	TickType_t xLastWakeTime = xTaskGetTickCount(); /* Initialize the lastWakeTime variable with the current time. */
 
+	networkHandlerTaskHandle = xTaskGetCurrentTaskHandle();
+
 	for(;;)
 	{
 		if(config.EnableRoutingAlgorithmTestBench)
 			vTaskDelayUntil( &xLastWakeTime, TestBenchModemSimulation_getNetworkHandlerDelay()); /* Wait for the next cycle */
+		else if(config.EventDrivenTasks)
+			ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(config.EventDrivenFallbackInterval)); /* Wait for work or the fallback tick */
 		else
 			vTaskDelayUntil( &xLastWakeTime, taskInterval); /* Wait for the next cycle */
 
+		networkHandler_run();
+	}
+}
 
-		/* generate data packages and put those into the package queue */
-		for(int deviceNr = 0; deviceNr<NUMBER_OF_UARTS; deviceNr++)
+/*!
+* \fn void networkHandler_run(void)
+* \brief One cycle of the network handler: routes generated packages to the wireless connections and
+* passes assembled packages up to the transport handler.
+*/
+void networkHandler_run(void)
+{
+	bool deviceDeferred[NUMBER_OF_UARTS] = {false, false, false, false};
+	bool progress = true;
+	tWirelessPackage nextPackage;
+	int8_t deviceNr;
+
+	/* the QoS scheduler chooses the device whose package is sent next, one package per round. If the next package of a device
+	 * finds no space on its links, the device is deferred until the next cycle so it does not block the other devices and the receive direction */
+	while(progress)
+	{
+		progress = false;
+
+		/* push generated wireless packages out on wireless side */
+		deviceNr = qosScheduleNextDevice(deviceDeferred, &nextPackage);
+		if(deviceNr >= 0)
 		{
-			/* push generated wireless packages out on wireless side */
-			//if( nofGeneratedPayloadPacksInQueue(deviceNr) > 0)
-			while( nofGeneratedPayloadPacksInQueue(deviceNr) > 0)
+			progress = true;
+			if(dispatchGeneratedPackage(deviceNr))
+			{
+				qosPackageDispatched(deviceNr, &nextPackage);
+			}
+			else
 			{
-				/* find wl connection to use for this package */
-				bool wlConnToUse[] = {false, false, false, false};
-				bool packSent = false;
+				deviceDeferred[deviceNr] = true;
+				numberOfDispatchStalls[deviceNr]++;
+			}
+		}
 
-				if(peekAtGeneratedPayloadPackInQueue(deviceNr, &package) == pdTRUE) /* peeking at package from upper handler successful? */
-				{
-					// Test-Packet: No routing needed
-					if(package.packType == PACK_TYPE_NETWORK_TEST_PACKAGE_FIRST || package.packType == PACK_TYPE_NETWORK_TEST_PACKAGE_SECOND)
-					{
-						oneToOnerouting(deviceNr, wlConnToUse);
-					}
-					// Acknowledges go back through the same modem as the payload came
-					else if(package.packType == PACK_TYPE_REC_ACKNOWLEDGE)
-					{
-						oneToOnerouting(package.payload[0], wlConnToUse);
-					}
-					// Panic Mode! Use all links
-					else if(package.panicMode && config.PrioDevice[package.devNum])
-					{
-						wlConnToUse[0] = true;
-						wlConnToUse[1] = true;
-						wlConnToUse[2] = true;
-						wlConnToUse[3] = true;
-					}
-					// Data-Packet gets routed with a routing algorithm
-					else if(!networkMetrics_getLinksToUse(sizeof(tWirelessPackage)+package.payloadSize, wlConnToUse, package.payloadNr,package.devNum))
-					{
-						//No link available at the moment... Dump Packet
-						packSent = true;
-					}
-
-					for(int wlConn = 0; wlConn < NUMBER_OF_UARTS; wlConn++)
-					{
-						/* this wlconn is configured for the desired priority and there is space in the queue of next handler? */
-						if( (wlConnToUse[wlConn] == true) && (freeSpaceInPackagesToDisassembleQueue(wlConn)) )
-						{
-
-								tWirelessPackage tmpPack;
-								copyPackage(&package, &tmpPack);
-
-								//IF Acknowledge, safe the Modem which the Ack is sent with (only needed for Logging...)
-								if(tmpPack.packType == PACK_TYPE_REC_ACKNOWLEDGE)
-									tmpPack.payload[0] = wlConn;
-
-								//Send the Pack
-								if(sendGeneratedWlPackage(&tmpPack, wlConn) == false) /* send the generated package down and store it internally if ACK is configured */
-								{
-									/* package couldnt be sent and payload was freed! don't access package anymore! */
-									break; /* exit innner for loop */
-								}
-
-								//Logging...
-								if(tmpPack.packType == PACK_TYPE_DATA_PACKAGE)
-									logger_incrementWirelessSentPack(wlConn);
-								packSent = true;
-						}
-					}
-				}
-				if(packSent)
-				{
-					popFromGeneratedPacksQueue(deviceNr, &package); /* this is done here because if two wlConn configured with same priority, package cant be removed twice */
-					vPortFree(package.payload);
-					package.payload = NULL;
-				}
+		//Route the packets from the Package Handler to the Transporthandler...
+		for(int wlConn = 0; wlConn<NUMBER_OF_UARTS; wlConn++)
+		{
+			if(nofAssembledPacksInQueue(wlConn) > 0 && processAssembledPackage(wlConn))
+			{
+				progress = true;
 			}
+		}
+	}
+}
+
+/*!
+* \fn static int8_t qosScheduleNextDevice(bool* deviceDeferred, tWirelessPackage* pNextPackage)
+* \brief QoS scheduler between the queues of generated packages and the wireless links. Devices with QOS_CLASS_STRICT_PRIORITY
+*  are always served first (round robin among them). The other devices share the links with deficit round robin: every
+*  round, each device gets QOS_WFQ_QUANTUM * QOS_WEIGHT bytes and sends packages as long as its deficit is big enough.
+*  The deficit is charged in qosPackageDispatched(), so a deferred package does not use up the share of its device.
+* \param pNextPackage: copy of the next package of the chosen device (still in the queue)
+* \return number of the device whose package should be sent next, -1 if no device has a package to send
+*/
+static int8_t qosScheduleNextDevice(bool* deviceDeferred, tWirelessPackage* pNextPackage)
+{
+	static uint8_t nextStrictDevice = 0;
+	static uint8_t currentWfqDevice = 0;
+	tWirelessPackage package[NUMBER_OF_UARTS];
+	bool deviceReady[NUMBER_OF_UARTS];
+	bool anyWfqDeviceReady = false;
 
+	for(int i = 0; i < NUMBER_OF_UARTS; i++)
+	{
+		deviceReady[i] = !deviceDeferred[i] && nofGeneratedPayloadPacksInQueue(i) > 0 && peekAtGeneratedPayloadPackInQueue(i, &package[i]) == pdTRUE;
+	}
+
+	for(int i = 0; i < NUMBER_OF_UARTS; i++)
+	{
+		uint8_t device = (nextStrictDevice + i) % NUMBER_OF_UARTS;
+		if(deviceReady[device] && config.QosClass[device] == QOS_CLASS_STRICT_PRIORITY)
+		{
+			nextStrictDevice = (device + 1) % NUMBER_OF_UARTS;
+			*pNextPackage = package[device];
+			return device;
+		}
+	}
 
-			//Route the packets from the Package Handler to the Transporthandler...
-			while(nofAssembledPacksInQueue(deviceNr) > 0)
+	for(int i = 0; i < NUMBER_OF_UARTS; i++)
+	{
+		if(config.QosClass[i] != QOS_CLASS_WEIGHTED_FAIR)
+		{
+			deviceReady[i] = false;
+		}
+		else if(nofGeneratedPayloadPacksInQueue(i) == 0)
+		{
+			qosDeficit[i] = 0; //Devices without packages don't collect credit
+		}
+		anyWfqDeviceReady |= deviceReady[i];
+	}
+	if(!anyWfqDeviceReady)
+	{
+		return -1;
+	}
+
+	/* QOS_WFQ_QUANTUM is at least the size of any package, so one round is always enough */
+	for(int n = 0; n <= 2*NUMBER_OF_UARTS; n++)
+	{
+		if(deviceReady[currentWfqDevice] && qosDeficit[currentWfqDevice] >= sizeof(tWirelessPackage) + package[currentWfqDevice].payloadSize)
+		{
+			*pNextPackage = package[currentWfqDevice];
+			return currentWfqDevice;
+		}
+		currentWfqDevice = (currentWfqDevice + 1) % NUMBER_OF_UARTS;
+		if(deviceReady[currentWfqDevice])
+		{
+			qosDeficit[currentWfqDevice] += config.QosWeight[currentWfqDevice] * QOS_WFQ_QUANTUM;
+		}
+	}
+	return -1;
+}
+
+/*!
+* \fn static void qosPackageDispatched(tUartNr deviceNr, tWirelessPackage* pPackage)
+* \brief Charges the package to the deficit of a weighted fair device and measures how long it waited in the queue
+*/
+static void qosPackageDispatched(tUartNr deviceNr, tWirelessPackage* pPackage)
+{
+	uint32_t bytes = sizeof(tWirelessPackage) + pPackage->payloadSize;
+	uint32_t queueingDelay = (xTaskGetTickCount() - pPackage->tickTimeQueued) * portTICK_PERIOD_MS;
+
+	if(config.QosClass[deviceNr] == QOS_CLASS_WEIGHTED_FAIR)
+	{
+		qosDeficit[deviceNr] = (qosDeficit[deviceNr] > bytes) ? qosDeficit[deviceNr] - bytes : 0;
+	}
+	queueingDelaySum[deviceNr] += queueingDelay;
+	numberOfQueueingDelaySamples[deviceNr]++;
+	if(queueingDelay > maxQueueingDelay[deviceNr])
+	{
+		maxQueueingDelay[deviceNr] = queueingDelay;
+	}
+}
+
+/*!
+* \fn static bool dispatchGeneratedPackage(tUartNr deviceNr)
+* \brief Routes the next generated package of the device and passes it to the package handler of the chosen links.
+*  If none of the chosen links has space, the package stays in the queue and keeps its routing decision for the next try,
+*  until the metrics task publishes a new routing decision.
+* \return true if the package was removed from the queue (sent or dumped), false if it was deferred
+*/
+static bool dispatchGeneratedPackage(tUartNr deviceNr)
+{
+	tWirelessPackage package;
+	bool* wlConnToUse = linksOfDeferredPackage[deviceNr];
+	bool packSent = false;
+	uint8_t nofLinksToUse = 0;
+
+	if(peekAtGeneratedPayloadPackInQueue(deviceNr, &package) != pdTRUE) /* peeking at package from upper handler successful? */
+	{
+		return false;
+	}
+
+	/* find wl connection to use for this package (a deferred package keeps its links until the routing decision changes) */
+	if(!deferredPackageRouted[deviceNr] || routingSequenceOfDeferredPackage[deviceNr] != networkMetrics_getRoutingSequence())
+	{
+		for(int wlConn = 0; wlConn < NUMBER_OF_UARTS; wlConn++)
+		{
+			wlConnToUse[wlConn] = false;
+		}
+		deferredPackageRouted[deviceNr] = true;
+		routingSequenceOfDeferredPackage[deviceNr] = networkMetrics_getRoutingSequence();
+		deferredPackageRoutedByMetrics[deviceNr] = false;
+
+		// Test-Packet: No routing needed
+		if(package.packType == PACK_TYPE_NETWORK_TEST_PACKAGE_FIRST || package.packType == PACK_TYPE_NETWORK_TEST_PACKAGE_SECOND)
+		{
+			oneToOnerouting(deviceNr, wlConnToUse);
+		}
+		// Acknowledges go back through the same modem as the payload came
+		else if(package.packType == PACK_TYPE_REC_ACKNOWLEDGE)
+		{
+			oneToOnerouting(package.payload[0], wlConnToUse);
+		}
+		// Panic Mode! Use all links
+		else if(package.panicMode && config.PrioDevice[package.devNum])
+		{
+			wlConnToUse[0] = true;
+			wlConnToUse[1] = true;
+			wlConnToUse[2] = true;
+			wlConnToUse[3] = true;
+		}
+		// Parity-Packet: sent once, on the link with the lowest load of the data links
+		else if(package.packType == PACK_TYPE_PARITY_PACKAGE)
+		{
+			deferredPackageRoutedByMetrics[deviceNr] = true;
+			if(!networkMetrics_getParityLinkToUse(sizeof(tWirelessPackage)+package.payloadSize, wlConnToUse, package.devNum))
 			{
-				processAssembledPackage(deviceNr);
+				packSent = true; //No link available at the moment... Dump Packet
+			}
+		}
+		// Data-Packet gets routed with a routing algorithm
+		else
+		{
+			deferredPackageRoutedByMetrics[deviceNr] = true;
+			if(!networkMetrics_getLinksToUse(sizeof(tWirelessPackage)+package.payloadSize, wlConnToUse, package.payloadNr, package.sendAttempt, package.devNum))
+			{
+				//No link available at the moment... Dump Packet
+				packSent = true;
 			}
 		}
 	}
+
+	for(int wlConn = 0; wlConn < NUMBER_OF_UARTS; wlConn++)
+	{
+		if(wlConnToUse[wlConn])
+		{
+			nofLinksToUse++;
+		}
+	}
+
+	for(int wlConn = 0; wlConn < NUMBER_OF_UARTS; wlConn++)
+	{
+		/* this wlconn is configured for the desired priority and there is space in the queue of next handler? */
+		if( (wlConnToUse[wlConn] == true) && (freeSpaceInPackagesToDisassembleQueue(wlConn)) )
+		{
+
+				tWirelessPackage tmpPack;
+				copyPackage(&package, &tmpPack);
+
+				//IF Acknowledge, safe the Modem which the Ack is sent with (only needed for Logging...)
+				if(tmpPack.packType == PACK_TYPE_REC_ACKNOWLEDGE)
+					tmpPack.payload[0] = wlConn;
+
+				//Send the Pack
+				if(sendGeneratedWlPackage(&tmpPack, wlConn) == false) /* send the generated package down and store it internally if ACK is configured */
+				{
+					/* package couldnt be sent and payload was freed! don't access package anymore! */
+					break; /* exit innner for loop */
+				}
+
+				if(deferredPackageRoutedByMetrics[deviceNr])
+					networkMetrics_chargeLink(wlConn, sizeof(tWirelessPackage)+package.payloadSize);
+
+				//Logging...
+				if(tmpPack.packType == PACK_TYPE_DATA_PACKAGE)
+				{
+					logger_incrementWirelessSentPack(wlConn);
+					if(nofLinksToUse == 1)
+						networkMetrics_passiveDataPackageSent(wlConn, &package); /* the acknowledge tells about this link */
+				}
+				packSent = true;
+		}
+	}
+	if(packSent)
+	{
+		popFromGeneratedPacksQueue(deviceNr, &package); /* this is done here because if two wlConn configured with same priority, package cant be removed twice */
+		vPortFree(package.payload);
+		package.payload = NULL;
+		deferredPackageRouted[deviceNr] = false;
+	}
+	return packSent;
+}
+
+/*!
+* \fn void networkHandler_notify(void)
+* \brief Wakes up the network handler task when EVENT_DRIVEN_TASKS is configured. Called by the tasks which put work into its queues.
+*/
+void networkHandler_notify(void)
+{
+	if(config.EventDrivenTasks && (networkHandlerTaskHandle != NULL))
+	{
+		xTaskNotifyGive(networkHandlerTaskHandle);
+	}
 }
 
 /*!
@@ -264,6 +476,7 @@ static bool processAssembledPackage(tUartNr wlConn)
 	if((package.packType == PACK_TYPE_DATA_PACKAGE) && (freeSpaceInReceivedPayloadPacksQueue(package.devNum) <= 0) ||
 	   (package.packType == PACK_TYPE_NETWORK_TEST_PACKAGE_FIRST) && (freeSpaceInReceivedPayloadPacksQueue(package.devNum) <= 0) ||
 	   (package.packType == PACK_TYPE_NETWORK_TEST_PACKAGE_SECOND) && (freeSpaceInReceivedPayloadPacksQueue(package.devNum) <= 0) ||
+	   (package.packType == PACK_TYPE_PARITY_PACKAGE) && (freeSpaceInReceivedPayloadPacksQueue(package.devNum) <= 0) ||
 	   ((package.packType == PACK_TYPE_REC_ACKNOWLEDGE) && (freeSpaceInPackagesToDisassembleQueue(wlConn) <= 0)) )
 	{
 		return false; /* not enough space */
@@ -273,7 +486,7 @@ static bool processAssembledPackage(tUartNr wlConn)
 	{
 		return false; /* coun't be removed */
 	}
-	if(package.packType <= PACK_TYPE_NETWORK_TEST_PACKAGE_SECOND) /* Known Package type received */
+	if(package.packType <= PACK_TYPE_PARITY_PACKAGE) /* Known Package type received */
 	{
 		/* check if data is valid */
 		if(package.payloadSize > PACKAGE_MAX_PAYLOAD_SIZE)
@@ -289,10 +502,26 @@ static bool processAssembledPackage(tUartNr wlConn)
 		{
 			logger_incrementWirelessReceivedPack(wlConn);
 			package.receivedModemNr = wlConn;
+
+			/* the same payload was already passed up through another link -> drop it, the acknowledge was already sent */
+			if(isRedundantCopy(&package))
+			{
+				numberOfSuppressedDuplicates[wlConn]++;
+				FRTOS_vPortFree(package.payload);
+				package.payload = NULL;
+				return true;
+			}
+		}
+		else if(package.packType == PACK_TYPE_PARITY_PACKAGE)
+		{
+			package.receivedModemNr = wlConn; /* acknowledges of rebuilt packages go back through this modem */
 		}
 
 		/* push package to Trandport handler for processing payload */
-		pushToReceivedPayloadPacksQueue(package.devNum, &package);
+		if(pushToReceivedPayloadPacksQueue(package.devNum, &package) == pdTRUE && package.packType == PACK_TYPE_DATA_PACKAGE)
+		{
+			markPayloadNrForwarded(&package);
+		}
 	}
 
 	else
@@ -303,3 +532,83 @@ static bool processAssembledPackage(tUartNr wlConn)
 	}
 	return true;
 }
+
+/*!
+* \fn static bool isRedundantCopy(tWirelessPackage* pPackage)
+* \brief Checks if a copy of this data package was already passed to the transport handler within the last half resend delay.
+*  A copy which arrives later is most probably a resend because the acknowledge got lost, so it is passed up once more
+*  and gets acknowledged again. Like this, all redundant copies of a package together trigger only one acknowledge.
+* \return true if the package can be dropped
+*/
+static bool isRedundantCopy(tWirelessPackage* pPackage)
+{
+	uint8_t deviceNr = pPackage->devNum;
+	uint16_t index = pPackage->payloadNr % DUPLICATE_WINDOW_SIZE;
+	uint16_t holdOffTicks = pdMS_TO_TICKS(networkMetrics_getResendDelayWirelessConn() / 2);
+
+	if(deviceNr >= NUMBER_OF_UARTS)
+	{
+		return false;
+	}
+	if(!duplicateWindowValid[deviceNr] || pPackage->sessionNr != sessionNrOfDuplicateWindow[deviceNr]) /* remote side restarted */
+	{
+		return false;
+	}
+	if(packageBuffer_isNewerPayloadNr(pPackage->payloadNr, newestForwardedPayloadNr[deviceNr]) ||
+	   (uint16_t)(newestForwardedPayloadNr[deviceNr] - pPackage->payloadNr) >= DUPLICATE_WINDOW_SIZE)
+	{
+		return false; /* not in the window, the transport handler decides */
+	}
+	if((forwardedPayloadNrBitmap[deviceNr][index / 32] & (1u << (index % 32))) == 0)
+	{
+		return false;
+	}
+	return ((uint16_t)((uint16_t)xTaskGetTickCount() - tickTimeForwarded[deviceNr][index]) < holdOffTicks);
+}
+
+/*!
+* \fn static void markPayloadNrForwarded(tWirelessPackage* pPackage)
+* \brief Stores in the duplicate window that the data package was passed to the transport handler.
+*  The window slides forward with the newest payloadNr, older payloadNrs fall out of it.
+*/
+static void markPayloadNrForwarded(tWirelessPackage* pPackage)
+{
+	uint8_t deviceNr = pPackage->devNum;
+	uint16_t index = pPackage->payloadNr % DUPLICATE_WINDOW_SIZE;
+
+	if(deviceNr >= NUMBER_OF_UARTS)
+	{
+		return;
+	}
+	if(!duplicateWindowValid[deviceNr] || pPackage->sessionNr != sessionNrOfDuplicateWindow[deviceNr])
+	{
+		for(int i = 0 ; i < DUPLICATE_WINDOW_SIZE/32 ; i++)
+		{
+			forwardedPayloadNrBitmap[deviceNr][i] = 0;
+		}
+		newestForwardedPayloadNr[deviceNr] = pPackage->payloadNr;
+		sessionNrOfDuplicateWindow[deviceNr] = pPackage->sessionNr;
+		duplicateWindowValid[deviceNr] = true;
+	}
+	else if(packageBuffer_isNewerPayloadNr(pPackage->payloadNr, newestForwardedPayloadNr[deviceNr]))
+	{
+		/* clear the slots which are reused for the payloadNrs between the old and the new newest one */
+		uint16_t distance = (uint16_t)(pPackage->payloadNr - newestForwardedPayloadNr[deviceNr]);
+		if(distance > DUPLICATE_WINDOW_SIZE)
+		{
+			distance = DUPLICATE_WINDOW_SIZE;
+		}
+		for(uint16_t i = 1 ; i <= distance ; i++)
+		{
+			uint16_t clearIndex = (uint16_t)(newestForwardedPayloadNr[deviceNr] + i) % DUPLICATE_WINDOW_SIZE;
+			forwardedPayloadNrBitmap[deviceNr][clearIndex / 32] &= ~(1u << (clearIndex % 32));
+		}
+		newestForwardedPayloadNr[deviceNr] = pPackage->payloadNr;
+	}
+	else if((uint16_t)(newestForwardedPayloadNr[deviceNr] - pPackage->payloadNr) >= DUPLICATE_WINDOW_SIZE)
+	{
+		return; /* too old for the window */
+	}
+	forwardedPayloadNrBitmap[deviceNr][index / 32] |= (1u << (index % 32));
+	tickTimeForwarded[deviceNr][index] = (uint16_t)xTaskGetTickCount();
+}
@@ -18,45 +18,133 @@
 #include "WirelessLink2Used.h"
 #include "WirelessLink3Used.h"
 #include "RNG.h"
+#include "ThroughputPrintout.h"
+#include "FixedPoint.h"
+
+/* data package whose acknowledge is awaited for the passive metrics */
+typedef struct sOutstandingPassivePack
+{
+	uint16_t payloadNr;
+	uint8_t devNum;
+	uint16_t bytes;
+	TickType_t sendTickTime;
+	bool retransmitted;		/* no RTT sample, the acknowledge could belong to an earlier send attempt */
+	bool inUse;
+} tOutstandingPassivePack;
+
+/* send and return of the test packages of one probe (packet train), stored at probeNr % PROBE_NOF_RECORDS */
+typedef struct sProbeRecord
+{
+	uint16_t probeNr;								/* packNr of all test packages of the probe */
+	uint16_t firstPayloadNr;						/* payloadNr of the first test package */
+	uint16_t sendTime[PROBE_TRAIN_MAX_LENGTH];		/* tick time when the test package was sent */
+	uint16_t arrivalTime[PROBE_TRAIN_MAX_LENGTH];	/* tick time when the returned test package arrived */
+	uint16_t frameSize[PROBE_TRAIN_MAX_LENGTH];		/* bytes of the returned test package on the link */
+	uint8_t sentMask;								/* bit x is set if the test package firstPayloadNr + x was sent */
+	uint8_t receivedMask;							/* bit x is set if the test package firstPayloadNr + x returned */
+	bool inUse;
+} tProbeRecord;
+
+/* trend of a metric (Holt's double exponential smoothing), level and slope are multiplied by TREND_SCALE */
+typedef struct sTrend
+{
+	int32_t level;
+	int32_t slope;			/* per metrics task interval */
+	bool initialized;
+} tTrend;
 
 /* global variables, only used in this file */
-static xQueueHandle queueRequestNewTestPacketPair; /* Outgoing Requests for new TestPacketPairs for the TransportHandler */
+static xQueueHandle queueRequestNewTestPacketPair[NUMBER_OF_UARTS]; /* Outgoing Requests for new TestPacketPairs for the TransportHandler, per wireless link */
 static xQueueHandle queueTestPacketResults; /* Incoming TestPacketPair Results from the TransportHandler */
-static const char* queueNameRequestNewTestPacketPair = {"RequestNewTestPacketPair"};
+static xQueueHandle queuePassiveMetricSamples; /* Incoming sent data packages and acknowledges from the Network- and TransportHandler */
+static const char* queueNameRequestNewTestPacketPair[] = {"RequestNewTestPacketPair0", "RequestNewTestPacketPair1", "RequestNewTestPacketPair2", "RequestNewTestPacketPair3"};
 static const char* queueNameTestPacketResults = {"TestPacketResults"};
-static tPackageBuffer testPackageBuffer[NUMBER_OF_UARTS];
-static bool packetLossIndicatorForPLR[NUMBER_OF_UARTS][NOF_PACKS_FOR_PACKET_LOSS_RATIO];
-static uint16_t indexOfPLRarray[NUMBER_OF_UARTS];
+static const char* queueNamePassiveMetricSamples = {"PassiveMetricSamples"};
+static tOutstandingPassivePack outstandingPassivePacks[NUMBER_OF_UARTS][PASSIVE_METRICS_NOF_OUTSTANDING_PACKS];
+static uint32_t passiveRTTsum[NUMBER_OF_UARTS];			/* sum and number of the RTT samples since the last metrics calculation */
+static uint16_t passiveNofRTTsamples[NUMBER_OF_UARTS];
+static uint32_t passiveAckedBytes[NUMBER_OF_UARTS];		/* acknowledged bytes since the last metrics calculation */
+static tProbeRecord probeRecords[NUMBER_OF_UARTS][PROBE_NOF_RECORDS];
+static uint16_t oldestProbeNr[NUMBER_OF_UARTS], newestProbeNr[NUMBER_OF_UARTS];	/* outstanding probes, checked for timeout from the oldest on */
+static bool pairMeasured[NUMBER_OF_UARTS];				/* RTT measured with the first test package pair of a probe since the last metrics calculation */
+static bool bandwidthMeasured[NUMBER_OF_UARTS];			/* bandwidth measured with a probe train since the last metrics calculation */
+static TickType_t timeStampLastValidMetric[NUMBER_OF_UARTS];
+static uint32_t probeBudgetMilliBytes[NUMBER_OF_UARTS];	/* airtime the probes of a link may still use (token bucket) */
+static TickType_t tickTimeLastPassiveSample[NUMBER_OF_UARTS];
+static bool passiveSampleReceived[NUMBER_OF_UARTS];
+static bool probePending[NUMBER_OF_UARTS];				/* test packet pair requested, no result yet */
+static TickType_t tickTimeLastProbeRequest[NUMBER_OF_UARTS];
+static tFixedPoint plrLostWeight[NUMBER_OF_UARTS], plrSampleWeight[NUMBER_OF_UARTS];	/* time weighted number of lost and of all packages */
+static TickType_t tickTimeLastPlrSample[NUMBER_OF_UARTS];
+static tFixedPoint plrHalfLife;
 static uint16_t RTTraw[NUMBER_OF_UARTS], RTTfiltered[NUMBER_OF_UARTS], SBPPraw[NUMBER_OF_UARTS], SBPPfiltered[NUMBER_OF_UARTS], CPP[NUMBER_OF_UARTS], PLR[NUMBER_OF_UARTS],Q[NUMBER_OF_UARTS];
-static uint16_t nofTransmittedBytesSinceLastTaskCall[NUMBER_OF_UARTS];
+static tFixedPoint RTTfilteredFixed[NUMBER_OF_UARTS], SBPPfilteredFixed[NUMBER_OF_UARTS];	/* filter states, RTTfiltered and SBPPfiltered are their rounded values */
+static tFixedPoint rttFilterParam, sbppFilterParam;
+static tTrend rttTrend[NUMBER_OF_UARTS], plrTrend[NUMBER_OF_UARTS], golayErrorTrend[NUMBER_OF_UARTS];
+static uint16_t Qpredicted[NUMBER_OF_UARTS];
+static uint32_t nofTransmittedBytesSinceLastTaskCall[NUMBER_OF_UARTS];	/* added by the network handler, read and cleared by the metrics task with atomic operations */
+static uint32_t stripingDeficit[NUMBER_OF_UARTS];							/* deficit round robin of chooseStripingLink(), only used by the network handler */
+static uint32_t nofTransmittedBytesLastInterval[NUMBER_OF_UARTS];			/* bytes routed to the links during the last interval of the metrics task */
 static bool wirelessLinksToUse[NUMBER_OF_UARTS];
-static SemaphoreHandle_t metricsSemaphore;
 static bool onlyPrioDeviceCanSend;
-static uint16_t payloadNrBuffer[PACKAGE_BUFFER_SIZE];
+static tRoutingState linkState[NUMBER_OF_UARTS] = {ROUTING_STATE_PANIC, ROUTING_STATE_PANIC, ROUTING_STATE_PANIC, ROUTING_STATE_PANIC}; /* best routing state the Q of the link allows, with hysteresis */
+static tRoutingState routingState = ROUTING_STATE_PANIC;
+static TickType_t tickTimeRoutingStateEntered;
+static tRoutingSnapshot routingSnapshot[2];								/* the metrics task writes the one which is not published */
+static volatile uint32_t routingSnapshotSequence;							/* routingSnapshot[routingSnapshotSequence & 1] is published */
+static tLinkMetrics linkMetricsSnapshot[2][NUMBER_OF_UARTS];				/* published together with routingSnapshot */
+
+/*! \def MEMORY_BARRIER
+*  \brief Makes sure the snapshot is written completely before the sequence counter changes (and read before it is checked)
+*/
+#define MEMORY_BARRIER()	__asm volatile ("dmb" ::: "memory")
 
 /* prototypes of local functions */
 static void initnetworkMetricsQueues(void);
 static BaseType_t  generateTestPacketPairRequest();
 static void calculateMetrics(void);
 static void copyTestPackagePayload(tWirelessPackage* testPackage, tTestPackagePayload* payload);
-static bool findPacketPairInBuffer(tWirelessPackage* sentPack1 , tWirelessPackage* sentPack2, tWirelessPackage* receivedPack1, tWirelessPackage* receivedPack2,uint16_t deviceID, uint16_t startPairNr);
-static bool calculateMetric_RoundTripTime(uint16_t* roundTripTime, tWirelessPackage* sentPack,tWirelessPackage* receivedPack);
-static bool calculateMetric_SenderBasedPacketPair(uint16_t* senderBasedPacketPair, tWirelessPackage* firstReceivedPackage,tWirelessPackage* secondReceivedPackage);
+static void processPassiveMetricSamples(void);
+static void passiveSampleDataSent(tPassiveMetricSample* sample);
+static void passiveSampleAckReceived(tPassiveMetricSample* sample);
+static void passivePackAcknowledged(uint8_t wirelessLink, tOutstandingPassivePack* pack, TickType_t ackTickTime, bool rttSampleValid);
+static bool linkHasPassiveMetrics(uint8_t wirelessLink);
+static bool probeIsDue(uint8_t wirelessLink);
+static void calculatePassiveMetrics(uint8_t wirelessLink);
+static void addToProbeRecord(tWirelessPackage* testPackage);
+static void finishProbe(uint8_t wirelessLink, tProbeRecord* record);
+static void expireProbes(uint8_t wirelessLink);
+static bool calculateMetric_RoundTripTime(uint16_t* roundTripTime, uint16_t sendTime, uint16_t arrivalTime);
+static bool calculateMetric_PacketTrainBandwidth(uint16_t* bandwidth, tProbeRecord* record);
 static bool calculateMetric_PacketLossRatio(uint16_t* packetLossRatio, uint8_t wirelessNr);
 static void updatePacketLossRatioPacketNOK(uint8_t wirelessNr);
 static void updatePacketLossRatioPacketOK(uint8_t wirelessNr);
+static void addPacketLossSample(uint8_t wirelessNr, bool packetLost);
 static void calculateQ(uint16_t SBPP,uint16_t RTT,uint16_t PLR,uint16_t CPP, uint16_t* Q);
-static void exponentialFilter(uint16_t* y_t, uint16_t* x_t, float a);
+static void exponentialFilter(tFixedPoint* y_fixed, uint16_t* y_t, uint16_t* x_t, tFixedPoint a);
+static void predictQ(uint8_t wirelessLink);
+static void updateTrend(tTrend* trend, uint16_t sample);
+static uint16_t getTrendRise(tTrend* trend, uint32_t nofIntervals);
 uint16_t getTimespan(uint16_t timestamp);
 static void routingAlgorithmusMetricsMethode();
 static void routingAlgorithmusHardRulesMethodeVariant1(uint8_t deviceNr,uint8_t sendTries);
 static void routingAlgorithmusHardRulesMethodeVariant2(uint8_t deviceNr,uint8_t sendTries);
 static void routingAlgorithmusHardRulesMethodeVariant3(uint8_t deviceNr,uint8_t sendTries, uint16_t payloadNr);
 static void getSortedQlist(uint16_t* sortedQlist,uint8_t* sortedQindexes);
-static void getLinksAboveQThreshold(bool* wirelessLinkIsAboveThreshold,bool onlyUseFreeLinks, uint16_t theshold,uint8_t* nofLinksAboveThreshold);
+static void updateLinkStates(void);
+static bool applyRoutingState(tRoutingState state);
+static void getLinksAboveQThreshold(bool* wirelessLinkIsAboveThreshold,bool onlyUseFreeLinks, tRoutingState state,uint8_t* nofLinksAboveThreshold);
 static bool chooseLinkWithHigestQandEnoughBandwith(uint8_t* bestLink,bool chooseTwoLinks);
 static void setLinksToUse(bool* wirelessLinksToSet);
-uint8_t getNofSendTries(uint8_t payloadNr);
+static int8_t chooseStripingLink(uint16_t bytesToSend, bool* linkCandidates);
+static int8_t chooseEarliestInOrderArrivalLink(uint16_t bytesToSend, bool* linkCandidates, uint8_t deviceNr);
+static uint32_t getLinkBandwidth(uint8_t wirelessLink);
+static uint32_t getBytesWaitingForTx(uint8_t wirelessLink);
+static uint32_t getBacklogDelay(uint8_t wirelessLink);
+static void avoidBackloggedLinks(bool* linksToUse, tRoutingSnapshot* snapshot);
+static void publishRoutingSnapshot(void);
+static void readRoutingSnapshot(tRoutingSnapshot* snapshot);
+static void addTransmittedBytes(uint8_t wirelessLink, uint16_t bytes);
 void setGPIOforUsedLinks(void);
 
 /*!
@@ -76,33 +164,16 @@ void networkMetrics_TaskEntry(void* p)
 
 		generateTestPacketPairRequest();
 
-		/* Put all Test-Packets from the Transport-Handler (queueTestPacketResults) into the PacketBuffer */
-		while(uxQueueMessagesWaiting( queueTestPacketResults )) /* While Test Packets in the Queue */
+		/* Store the sent and returned Test-Packets from the Transport-Handler (queueTestPacketResults) in the probe records */
+		while(xQueueReceive(queueTestPacketResults, &package, 0) == pdTRUE)
 		{
-			xQueuePeek( queueTestPacketResults, &package, 0);
-			if(packageBuffer_putNotUnique(&testPackageBuffer[package.devNum],&package) != true)
-			{
-				// No free space in the buffer
-				break;
-			}
-			else
-			{
-				/* update the PacketLossRatio Metric array*/
-				tTestPackagePayload payload;
-				copyTestPackagePayload(&package,&payload);
-				if(payload.returned)
-				{
-					updatePacketLossRatioPacketOK(package.devNum);
-				}
-
-				/* Delete the test packet from the queue */
-				packageBuffer_setCurrentPayloadNR(&testPackageBuffer[package.devNum],package.payloadNr); //Set the highest TestPacket Number in the buffer
-				xQueueReceive(queueTestPacketResults, &package, 0);
-				vPortFree(package.payload);
-				package.payload = NULL;
-			}
+			addToProbeRecord(&package);
+			vPortFree(package.payload);
+			package.payload = NULL;
 		}
 
+		processPassiveMetricSamples();
+
 		routingAlgorithmusMetricsMethode();
 	}
 }
@@ -116,11 +187,13 @@ void networkMetrics_TaskInit(void)
 	initnetworkMetricsQueues();
 	for(int i = 0; i< NUMBER_OF_UARTS ; i++)
 	{
-		packageBuffer_init(&testPackageBuffer[i]);
-		packageBuffer_setCurrentPayloadNR(&testPackageBuffer[i],1);
+		oldestProbeNr[i] = newestProbeNr[i] + 1; /* no probe outstanding */
+		probeBudgetMilliBytes[i] = PROBE_PACK_AIRTIME_BYTES * config.ProbeTrainLengthWlConn[i] * 1000; /* the first probe can be sent right away */
 	}
-
-	 metricsSemaphore = xSemaphoreCreateBinary();
+	rttFilterParam = fixedPoint_fromPerMille(config.RttFilterParam);
+	sbppFilterParam = fixedPoint_fromPerMille(config.SbppFilterParam);
+	plrHalfLife = fixedPoint_fromInt(config.PlrHalfLife);
+	publishRoutingSnapshot();
 }
 
 /*!
@@ -130,13 +203,9 @@ void networkMetrics_TaskInit(void)
 static void calculateMetrics(void)
 {
 	char infoBuf[100];
-	static uint16_t timeStampLastValidMetric[NUMBER_OF_UARTS];
-	static uint16_t currentPairNr[NUMBER_OF_UARTS] = {1,1,1,1};
 
 	for(int wirelessLink = 0 ;  wirelessLink < NUMBER_OF_UARTS ; wirelessLink ++)
 	{
-		bool foundPair[NUMBER_OF_UARTS] = {false,false,false,false};
-
 		/*            					  -------------      -------------
 		 * 	 Sender ---------->  		 | sentPack1   |    | sentPack2   |   	----------> Receiver
 		 * 	 							 | Payload x   |	| Payload y   |
@@ -147,84 +216,69 @@ static void calculateMetrics(void)
 		 * 	 							 | Payload x   |	| Payload y   |
 		 * 	 							 | ret = true  |	| ret = true  |
 		 *            					  -------------      -------------
+		 * The RTT is measured when both packages of the first pair of a probe returned,
+		 * the bandwidth when the whole probe train returned or timed out (see addToProbeRecord())
 		 */
 
-		tWirelessPackage sentPack1 , sentPack2, receivedPack1, receivedPack2, tempPack;
-		tTestPackagePayload payload;
+		expireProbes(wirelessLink);
 
-		for(int i = currentPairNr[wirelessLink] ;  i <= packageBuffer_getCurrentPayloadNR(&testPackageBuffer[wirelessLink]) ; i++)
+		if(pairMeasured[wirelessLink])
 		{
-			//Found correct packet pair in buffer
-			if(findPacketPairInBuffer(&sentPack1 , &sentPack2, &receivedPack1, &receivedPack2,wirelessLink,i))
-			{
-
-				foundPair[wirelessLink] = true;
-				timeStampLastValidMetric[wirelessLink] = xTaskGetTickCount();
-
-				calculateMetric_RoundTripTime(&RTTraw[wirelessLink],&sentPack1,&receivedPack1);
-				exponentialFilter(&RTTfiltered[wirelessLink],&RTTraw[wirelessLink],RRT_FILTER_PARAM);
-				calculateMetric_RoundTripTime(&RTTraw[wirelessLink],&sentPack2,&receivedPack2);
-				exponentialFilter(&RTTfiltered[wirelessLink],&RTTraw[wirelessLink],RRT_FILTER_PARAM);
-				calculateMetric_SenderBasedPacketPair(&SBPPraw[wirelessLink],&receivedPack1,&receivedPack2);
-				exponentialFilter(&SBPPfiltered[wirelessLink],&SBPPraw[wirelessLink],SBPP_FILTER_PARAM);
-				calculateMetric_PacketLossRatio(&PLR[wirelessLink], wirelessLink);
-				CPP[wirelessLink] = config.CostPerPacketMetric[wirelessLink];
-
-				vPortFree(sentPack1.payload);
-				sentPack1.payload = NULL;
-				vPortFree(sentPack2.payload);
-				sentPack2.payload = NULL;
-				vPortFree(receivedPack1.payload);
-				receivedPack1.payload = NULL;
-				vPortFree(receivedPack2.payload);
-				receivedPack2.payload = NULL;
+			calculateMetric_PacketLossRatio(&PLR[wirelessLink], wirelessLink);
+			CPP[wirelessLink] = config.CostPerPacketMetric[wirelessLink];
 
 #ifdef PRINT_METRICS
-				XF1_xsprintf(infoBuf, "----------- WrelessLink%u Metrics -----------\r\n",wirelessLink);
-				pushMsgToShellQueue(infoBuf);
-				XF1_xsprintf(infoBuf, "Raw RRT = %u ms \tFiltered RRT = %u ms\r\n", RTTraw[wirelessLink], RTTfiltered[wirelessLink]);
-				pushMsgToShellQueue(infoBuf);
-				XF1_xsprintf(infoBuf, "Raw SBPP = %u Byte/s \t\tFiltered SBPP = %u\r\n", SBPPraw[wirelessLink],SBPPfiltered[wirelessLink]);
-				pushMsgToShellQueue(infoBuf);
-				XF1_xsprintf(infoBuf, "PLR = %u %% \r\n", PLR[wirelessLink]);
-				pushMsgToShellQueue(infoBuf);
-				XF1_xsprintf(infoBuf, "CPP = %u  \r\n", CPP[wirelessLink]);
+			XF1_xsprintf(infoBuf, "----------- WrelessLink%u Metrics -----------\r\n",wirelessLink);
+			pushMsgToShellQueue(infoBuf);
+			XF1_xsprintf(infoBuf, "Raw RRT = %u ms \tFiltered RRT = %u ms\r\n", RTTraw[wirelessLink], RTTfiltered[wirelessLink]);
+			pushMsgToShellQueue(infoBuf);
+			XF1_xsprintf(infoBuf, "Raw SBPP = %u Byte/s \t\tFiltered SBPP = %u\r\n", SBPPraw[wirelessLink],SBPPfiltered[wirelessLink]);
+			pushMsgToShellQueue(infoBuf);
+			XF1_xsprintf(infoBuf, "PLR = %u per mille \r\n", PLR[wirelessLink]);
+			pushMsgToShellQueue(infoBuf);
+			XF1_xsprintf(infoBuf, "CPP = %u  \r\n", CPP[wirelessLink]);
+			pushMsgToShellQueue(infoBuf);
+			if(passiveNofRTTsamples[wirelessLink] > 0)
+			{
+				XF1_xsprintf(infoBuf, "Passive RRT = %u ms \tPassive bandwidth = %u Byte/s\r\n", passiveRTTsum[wirelessLink]/passiveNofRTTsamples[wirelessLink], (passiveAckedBytes[wirelessLink]*1000)/config.NetworkMetricsTaskInterval);
 				pushMsgToShellQueue(infoBuf);
-#endif
-
 			}
+#endif
 		}
-
-		if(foundPair[wirelessLink] == false) //found no valid packet pair...
+		else if(linkHasPassiveMetrics(wirelessLink)) //found no valid packet pair, but the link carries acknowledged data
 		{
-			if(RTTraw[wirelessLink]<TIMEOUT_TEST_PACKET_RETURN)
-			{
-				RTTraw[wirelessLink] = getTimespan(timeStampLastValidMetric[wirelessLink]);
-			}
-			exponentialFilter(&RTTfiltered[wirelessLink],&RTTraw[wirelessLink],RRT_FILTER_PARAM);
-			SBPPraw[wirelessLink] = 0;
-			exponentialFilter(&SBPPfiltered[wirelessLink],&SBPPraw[wirelessLink],SBPP_FILTER_PARAM);
+			timeStampLastValidMetric[wirelessLink] = xTaskGetTickCount();
+			calculatePassiveMetrics(wirelessLink);
 		}
-
-		while(packageBuffer_getNextPackageOlderThanTimeout(&testPackageBuffer[wirelessLink],&tempPack,TIMEOUT_TEST_PACKET_RETURN))
+		else if(!probePending[wirelessLink] && config.UseProbingPacksWlConn[wirelessLink])
+		{
+			//The probe scheduler did not probe the link since the last valid metric -> keep the metrics
+		}
+		else //found no valid packet pair...
 		{
-			/* update the PacketLossRatio Metric array*/
-			tTestPackagePayload payload;
-			copyTestPackagePayload(&tempPack,&payload);
-			if(!payload.returned)
+			if(RTTraw[wirelessLink]<TIMEOUT_TEST_PACKET_RETURN)
 			{
-				updatePacketLossRatioPacketNOK(wirelessLink);
+				//Time the probe is outstanding (the link may not have been probed for a while before)
+				uint16_t timeStampReference = (uint16_t)timeStampLastValidMetric[wirelessLink];
+				if(probePending[wirelessLink] && getTimespan((uint16_t)tickTimeLastProbeRequest[wirelessLink]) < getTimespan(timeStampReference))
+				{
+					timeStampReference = (uint16_t)tickTimeLastProbeRequest[wirelessLink];
+				}
+				RTTraw[wirelessLink] = getTimespan(timeStampReference);
 			}
-
-			if(currentPairNr[wirelessLink] < tempPack.payloadNr)
+			exponentialFilter(&RTTfilteredFixed[wirelessLink],&RTTfiltered[wirelessLink],&RTTraw[wirelessLink],rttFilterParam);
+			if(!bandwidthMeasured[wirelessLink])
 			{
-				currentPairNr[wirelessLink] = tempPack.payloadNr;
+				SBPPraw[wirelessLink] = 0;
+				exponentialFilter(&SBPPfilteredFixed[wirelessLink],&SBPPfiltered[wirelessLink],&SBPPraw[wirelessLink],sbppFilterParam);
 			}
-			vPortFree(tempPack.payload);
-			tempPack.payload = NULL;
 		}
 
-		packageBuffer_freeOlderThanCurrentPackage(&testPackageBuffer[wirelessLink]);
+		pairMeasured[wirelessLink] = false;
+		bandwidthMeasured[wirelessLink] = false;
+		passiveRTTsum[wirelessLink] = 0;
+		passiveNofRTTsamples[wirelessLink] = 0;
+		passiveAckedBytes[wirelessLink] = 0;
 	}
 
 	for(int wirelessLink = 0 ;  wirelessLink < NUMBER_OF_UARTS ; wirelessLink ++)
@@ -232,8 +286,9 @@ static void calculateMetrics(void)
 		calculateMetric_PacketLossRatio(&PLR[wirelessLink], wirelessLink);
 
 		calculateQ(SBPPfiltered[wirelessLink],RTTfiltered[wirelessLink],PLR[wirelessLink],CPP[wirelessLink],&Q[wirelessLink]);
+		predictQ(wirelessLink);
 #if defined(PRINT_METRICS) || defined(PRINT_Q)
-		XF1_xsprintf(infoBuf, "Q%u = %u  \r\n", wirelessLink,Q[wirelessLink]);
+		XF1_xsprintf(infoBuf, "Q%u = %u  predicted = %u\r\n", wirelessLink,Q[wirelessLink],Qpredicted[wirelessLink]);
 		pushMsgToShellQueue(infoBuf);
 #endif
 	}
@@ -242,82 +297,64 @@ static void calculateMetrics(void)
 /*!
 * \fn void routingAlgorithmusMetricsMethode()
 * \brief implements the routing algorithm with network metrics
+*  The routing uses the best routing state which has links above its Q threshold. Once entered, a state is kept for
+*  at least config.RoutingStateMinDwell, as long as it still has links (no flapping between the states).
 */
 static void routingAlgorithmusMetricsMethode(void)
 {
-	uint8_t nofLinksAboveThreshold;
-	bool routingDone = false;
-	bool linksAboveQthreshold[NUMBER_OF_UARTS];
+	bool linkWasUsed[NUMBER_OF_UARTS];
+	tRoutingState newState;
 
 	calculateMetrics();
 
-	getLinksAboveQThreshold(linksAboveQthreshold,true,Q_HIGH_THRESHOLD,&nofLinksAboveThreshold);
-	//Algorithm Case 1: There are links with high Q  -> Use the Link with higest Q
-	if(nofLinksAboveThreshold)
+	//Bytes routed since the last call, the network handler keeps on counting in the meantime
+	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
 	{
-		uint8_t bestWirelessLink;
-
-		if(config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_1)
-		{
-			routingDone = chooseLinkWithHigestQandEnoughBandwith(&bestWirelessLink,false);
-		}
-		else if(config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_2 || config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_3)
-		{
-			//Fast Adoption: Use Case2 if the Bandwith is falling use two links
-			routingDone = chooseLinkWithHigestQandEnoughBandwith(&bestWirelessLink,false);
-			if(SBPPraw[bestWirelessLink] == 0)
-			{
-				routingDone = chooseLinkWithHigestQandEnoughBandwith(&bestWirelessLink,true);
-			}
-		}
-		onlyPrioDeviceCanSend = false;
+		nofTransmittedBytesLastInterval[i] = __atomic_exchange_n(&nofTransmittedBytesSinceLastTaskCall[i], 0, __ATOMIC_RELAXED);
+		linkWasUsed[i] = wirelessLinksToUse[i];
 	}
 
-	//Algorithm Case 2: There are links with mid Q  -> Use all free (CPP = 1) links (redundant sending) above Threshold Mid
-	if(!routingDone)
+	updateLinkStates();
+
+	if((xTaskGetTickCount() - tickTimeRoutingStateEntered) < pdMS_TO_TICKS(config.RoutingStateMinDwell[routingState]) &&
+	   applyRoutingState(routingState))
 	{
-		getLinksAboveQThreshold(linksAboveQthreshold,true,Q_MID_THRESHOLD,&nofLinksAboveThreshold);
-		if(nofLinksAboveThreshold)
-		{
-			setLinksToUse(linksAboveQthreshold);
-			routingDone = true;
-			onlyPrioDeviceCanSend = false;
-		}
+		newState = routingState; //dwell time not over yet
 	}
-
-	//Algorithm Case 3: There are links with low Q  -> Use all links (redundant sending) above Threshold Low
-	if(!routingDone)
+	else
 	{
-		getLinksAboveQThreshold(linksAboveQthreshold,false,Q_LOW_THRESHOLD,&nofLinksAboveThreshold);
-		if(nofLinksAboveThreshold)
+		newState = ROUTING_STATE_SINGLE_LINK;
+		while(!applyRoutingState(newState)) //the panic state is always possible
 		{
-			setLinksToUse(linksAboveQthreshold);
-			routingDone = true;
-			onlyPrioDeviceCanSend = false;
+			newState++;
 		}
 	}
+	if(newState != routingState)
+	{
+		routingState = newState;
+		tickTimeRoutingStateEntered = xTaskGetTickCount();
+	}
 
-	//Algorithm Case 4: There are no links above any threshold  -> Use all links and only Send Data from Prio Device
-	//This case also gets used, if the panic Button is pressed
-	if(!routingDone || PanicButton_GetVal())
+	//The panic Button forces Case 4 without changing the routing state
+	if(PanicButton_GetVal())
 	{
-		if(xSemaphoreTake(metricsSemaphore,pdMS_TO_TICKS(50)))
+		onlyPrioDeviceCanSend = true;
+		for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
 		{
-			onlyPrioDeviceCanSend = true;
-			for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
-			{
-				wirelessLinksToUse[i] = true;
-			}
+			wirelessLinksToUse[i] = true;
 		}
-		xSemaphoreGive(metricsSemaphore);
 	}
 
-	//Clear Byte Counters
 	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
 	{
-		nofTransmittedBytesSinceLastTaskCall[i] = 0;
+		if(wirelessLinksToUse[i] != linkWasUsed[i])
+		{
+			numberOfLinkRoutingTransitions[i]++;
+		}
 	}
 
+	publishRoutingSnapshot();
+
 	//print results
 #ifdef PRINT_WIRELESSLINK_TO_USE
 	char infoBuf[100];
@@ -335,6 +372,108 @@ static void routingAlgorithmusMetricsMethode(void)
 	setGPIOforUsedLinks();
 }
 
+/*!
+* \fn static void updateLinkStates(void)
+* \brief Updates the best routing state every link can be used in from its Q, with hysteresis:
+*  A link enters a better state when Q reaches config.QthresholdEnter of the state and leaves it when Q falls below config.QthresholdExit.
+*  If the predicted Q is lower, it is used instead of Q (see predictQ())
+*/
+static void updateLinkStates(void)
+{
+	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+	{
+		tRoutingState state = linkState[i];
+		uint16_t q = (Qpredicted[i] < Q[i]) ? Qpredicted[i] : Q[i]; /* a degrading link leaves its state before its Q is too low */
+
+		while(state < ROUTING_STATE_PANIC && q < config.QthresholdExit[state])
+		{
+			state++;
+		}
+		for(tRoutingState betterState = ROUTING_STATE_SINGLE_LINK ; betterState < state ; betterState++)
+		{
+			if(q >= config.QthresholdEnter[betterState])
+			{
+				state = betterState;
+				break;
+			}
+		}
+		if(state != linkState[i])
+		{
+			linkState[i] = state;
+			numberOfLinkStateTransitions[i]++;
+		}
+	}
+}
+
+/*!
+* \fn static bool applyRoutingState(tRoutingState state)
+* \brief Sets wirelessLinksToUse and onlyPrioDeviceCanSend according to the routing state
+* \return false if the state has no link to use (state is not possible), the panic state is always possible
+*/
+static bool applyRoutingState(tRoutingState state)
+{
+	uint8_t nofLinksAboveThreshold;
+	bool routingDone = false;
+	bool linksAboveQthreshold[NUMBER_OF_UARTS];
+
+	switch(state)
+	{
+	//Algorithm Case 1: There are links with high Q  -> Use the Link with higest Q
+	case ROUTING_STATE_SINGLE_LINK:
+		getLinksAboveQThreshold(linksAboveQthreshold,true,state,&nofLinksAboveThreshold);
+		if(nofLinksAboveThreshold)
+		{
+			uint8_t bestWirelessLink;
+
+			if(config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_1)
+			{
+				routingDone = chooseLinkWithHigestQandEnoughBandwith(&bestWirelessLink,false);
+			}
+			else if(config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_2 || config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_3)
+			{
+				//Fast Adoption: Use Case2 if the Bandwith is falling use two links
+				routingDone = chooseLinkWithHigestQandEnoughBandwith(&bestWirelessLink,false);
+				if(SBPPraw[bestWirelessLink] == 0)
+				{
+					routingDone = chooseLinkWithHigestQandEnoughBandwith(&bestWirelessLink,true);
+				}
+			}
+			else if(config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_4 || config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_5)
+			{
+				//Striping: all links with high Q are used, networkMetrics_getLinksToUse() distributes the packages over them
+				setLinksToUse(linksAboveQthreshold);
+				routingDone = true;
+			}
+			onlyPrioDeviceCanSend = false;
+		}
+		break;
+
+	//Algorithm Case 2: There are links with mid Q  -> Use all free (CPP = 1) links (redundant sending) above Threshold Mid
+	//Algorithm Case 3: There are links with low Q  -> Use all links (redundant sending) above Threshold Low
+	case ROUTING_STATE_REDUNDANT_FREE_LINKS:
+	case ROUTING_STATE_REDUNDANT_ALL_LINKS:
+		getLinksAboveQThreshold(linksAboveQthreshold,(state == ROUTING_STATE_REDUNDANT_FREE_LINKS),state,&nofLinksAboveThreshold);
+		if(nofLinksAboveThreshold)
+		{
+			setLinksToUse(linksAboveQthreshold);
+			routingDone = true;
+			onlyPrioDeviceCanSend = false;
+		}
+		break;
+
+	//Algorithm Case 4: There are no links above any threshold  -> Use all links and only Send Data from Prio Device
+	default:
+		onlyPrioDeviceCanSend = true;
+		for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+		{
+			wirelessLinksToUse[i] = true;
+		}
+		routingDone = true;
+		break;
+	}
+	return routingDone;
+}
+
 /*!
 * \fn void routingAlgorithmusHardRulesMethodeVariant1()
 * \brief implements the routing algorithm with hard rules Variant1
@@ -641,17 +780,17 @@ static void getSortedQlist(uint16_t sortedQlist[NUMBER_OF_UARTS],uint8_t sortedQ
 }
 
 /*!
-* \fn  void getLinksAboveQThreshold(bool* wirelessLinkIsAboveThreshold,uint16_t threshold)
-* \brief checks if threshold is met by a wirelessLink
+* \fn  void getLinksAboveQThreshold(bool* wirelessLinkIsAboveThreshold,bool onlyUseFreeLinks, tRoutingState state,uint8_t* nofLinksAboveThreshold)
+* \brief checks which wirelessLinks can be used in the routing state (Q threshold of the state met, see updateLinkStates())
 * if onlyUseFreeLinks == true, only Links with CPP = 1 are used
 */
-static void getLinksAboveQThreshold(bool wirelessLinkIsAboveThreshold[NUMBER_OF_UARTS],bool onlyUseFreeLinks, uint16_t theshold,uint8_t nofLinksAboveThreshold[NUMBER_OF_UARTS])
+static void getLinksAboveQThreshold(bool wirelessLinkIsAboveThreshold[NUMBER_OF_UARTS],bool onlyUseFreeLinks, tRoutingState state,uint8_t nofLinksAboveThreshold[NUMBER_OF_UARTS])
 {
 	*nofLinksAboveThreshold = 0;
 	for(int i=0 ; i<NUMBER_OF_UARTS ; i++)
 	{
-		if((Q[i]>=theshold && onlyUseFreeLinks && CPP[i] == 1) ||
-		   (Q[i]>=theshold && !onlyUseFreeLinks))
+		if((linkState[i]<=state && onlyUseFreeLinks && CPP[i] == 1) ||
+		   (linkState[i]<=state && !onlyUseFreeLinks))
 		{
 			*nofLinksAboveThreshold = *nofLinksAboveThreshold+1;
 			wirelessLinkIsAboveThreshold[i]=true;
@@ -675,36 +814,33 @@ static bool chooseLinkWithHigestQandEnoughBandwith(uint8_t* bestLink,bool choose
 	bool channelFound = false;
 
 	//Search for the channel with higest q and lower Bandwith usage than BANDWITH_USAGE_PER_CHANNEL
-	if(xSemaphoreTake(metricsSemaphore,pdMS_TO_TICKS(50)))
+	getSortedQlist(sortedQlist,sortedQindexes);
+	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
 	{
-		getSortedQlist(sortedQlist,sortedQindexes);
-		for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+		if(sortedQindexes[i] != NUMBER_OF_UARTS &&
+		  ((nofTransmittedBytesLastInterval[sortedQindexes[i]]*1000/config.NetworkMetricsTaskInterval) < (BANDWITH_USAGE_PER_CHANNEL*SBPPfiltered[sortedQindexes[i]])) &&
+		  (getBacklogDelay(sortedQindexes[i]) < MAX_LINK_BACKLOG_MS))
 		{
-			if(sortedQindexes[i] != NUMBER_OF_UARTS &&
-			  ((nofTransmittedBytesSinceLastTaskCall[sortedQindexes[i]]*1000/config.NetworkMetricsTaskInterval) < (BANDWITH_USAGE_PER_CHANNEL*SBPPfiltered[sortedQindexes[i]])))
+			for(int j = 0 ; j < NUMBER_OF_UARTS ; j++)
 			{
-				for(int j = 0 ; j < NUMBER_OF_UARTS ; j++)
+				if(j == sortedQindexes[i])
 				{
-					if(j == sortedQindexes[i])
-					{
-						wirelessLinksToUse[j] = true;
-						channelFound=true;
-						*bestLink = j;
-					}
-					else if(chooseTwoLinks  && j == sortedQindexes[i+1])
-					{
-						wirelessLinksToUse[j] = true;
-					}
-					else
-					{
-						wirelessLinksToUse[j] = false;
-					}
+					wirelessLinksToUse[j] = true;
+					channelFound=true;
+					*bestLink = j;
+				}
+				else if(chooseTwoLinks  && j == sortedQindexes[i+1])
+				{
+					wirelessLinksToUse[j] = true;
+				}
+				else
+				{
+					wirelessLinksToUse[j] = false;
 				}
-				break;
 			}
+			break;
 		}
 	}
-	xSemaphoreGive(metricsSemaphore);
 	return channelFound;
 }
 
@@ -714,233 +850,844 @@ static bool chooseLinkWithHigestQandEnoughBandwith(uint8_t* bestLink,bool choose
 */
 static void setLinksToUse(bool* wirelessLinksToSet)
 {
-	if(xSemaphoreTake(metricsSemaphore,pdMS_TO_TICKS(50)))
+	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
 	{
-		for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
-		{
-			wirelessLinksToUse[i] = wirelessLinksToSet[i];
-		}
+		wirelessLinksToUse[i] = wirelessLinksToSet[i];
 	}
-	xSemaphoreGive(metricsSemaphore);
 }
 
 /*!
-* \fn  void networkMetrics_getLinksToUse(uint16_t bytesToSend,bool* wirelessLinksToUseParam)
-*  in the Bool-Array wirelessLinksToUseParam the wireless links to use get saved. They are choosen by the routingAlgorithm
-*  if priorityData==true, the Data is handled with priority
-*  \return true, if packet has a link to be sent, false if no link is available at the moment
+* \fn static void publishRoutingSnapshot(void)
+* \brief Copies the routing decision into the snapshot which is not published and publishes it by incrementing the
+*  sequence counter. Only called by the metrics task.
 */
-bool networkMetrics_getLinksToUse(uint16_t bytesToSend,bool* wirelessLinksToUseParam, uint16_t payloadNr, uint8_t deviceNr)
+static void publishRoutingSnapshot(void)
 {
-	bool packetSendable = false;
-	uint8_t sendTries = getNofSendTries(payloadNr);
+	uint32_t sequence = routingSnapshotSequence;
+	tRoutingSnapshot* snapshot = &routingSnapshot[(sequence + 1) & 1];
+	tLinkMetrics* linkMetrics = linkMetricsSnapshot[(sequence + 1) & 1];
+	uint16_t sortedQlist[NUMBER_OF_UARTS];
 
-	if(config.RoutingMethode == ROUTING_METHODE_HARD_RULES)
+	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
 	{
-		if(config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_1)
-		{
-			routingAlgorithmusHardRulesMethodeVariant1(deviceNr,sendTries);
-		}
-		else if(config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_2)
-		{
-			routingAlgorithmusHardRulesMethodeVariant2(deviceNr,sendTries);
-		}
-		else if(config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_3)
-		{
-			routingAlgorithmusHardRulesMethodeVariant3(deviceNr,sendTries, payloadNr);
-		}
-		for(int i=0 ; i<NUMBER_OF_UARTS ; i++)
-		{
-			wirelessLinksToUseParam[i] = wirelessLinksToUse[i];
-			if(wirelessLinksToUse[i])
-			{
-				packetSendable = true;
-			}
-		}
+		snapshot->wirelessLinksToUse[i] = wirelessLinksToUse[i];
+		snapshot->Q[i] = Q[i];
+		linkMetrics[i].RTTraw = RTTraw[i];
+		linkMetrics[i].RTTfiltered = RTTfiltered[i];
+		linkMetrics[i].SBPPraw = SBPPraw[i];
+		linkMetrics[i].SBPPfiltered = SBPPfiltered[i];
+		linkMetrics[i].PLR = PLR[i];
+		linkMetrics[i].CPP = CPP[i];
+		linkMetrics[i].Q = Q[i];
+		linkMetrics[i].Qpredicted = Qpredicted[i];
+		linkMetrics[i].linkState = linkState[i];
+		linkMetrics[i].routingState = routingState;
+		linkMetrics[i].used = wirelessLinksToUse[i];
 	}
+	snapshot->onlyPrioDeviceCanSend = onlyPrioDeviceCanSend;
+	getSortedQlist(sortedQlist,snapshot->sortedQindexes);
 
-	if(config.RoutingMethode == ROUTING_METHODE_METRICS)
-	{
-		if(xSemaphoreTake(metricsSemaphore,pdMS_TO_TICKS(50)))
-		{
-			if(!onlyPrioDeviceCanSend || config.PrioDevice[deviceNr])
-			{
-				uint8_t numberOfUsedChannels = 0;
-				for(int i=0 ; i<NUMBER_OF_UARTS ; i++)
-				{
-					if(wirelessLinksToUse[i])
-					{
-						numberOfUsedChannels++;
-						nofTransmittedBytesSinceLastTaskCall[i] += bytesToSend;
-					}
-					wirelessLinksToUseParam[i] = wirelessLinksToUse[i];
-
-					if(wirelessLinksToUse[i])
-					{
-						packetSendable = true;
-					}
-
-				}
-
-				if(config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_3 && numberOfUsedChannels == 1 && sendTries>1)
-				{
-					uint16_t sortedQlist[NUMBER_OF_UARTS];
-					uint8_t sortedQindexes[NUMBER_OF_UARTS];
-					getSortedQlist(sortedQlist,sortedQindexes);
-					for(int i=0 ; i<NUMBER_OF_UARTS ; i++)
-					{
-						if(i == sortedQindexes[0] || i == sortedQindexes[1])
-						{
-							wirelessLinksToUseParam[i] = true;
-						}
-					}
-				}
-			}
-			else
-			{
-				for(int i=0 ; i<NUMBER_OF_UARTS ; i++)
-				{
-					wirelessLinksToUseParam[i] = false;
-				}
-			}
-		}
-
-		xSemaphoreGive(metricsSemaphore);
-	}
-	return packetSendable;
+	MEMORY_BARRIER();
+	routingSnapshotSequence = sequence + 1;
 }
 
-
 /*!
-* \fn void exponentialFilter(uint16_t y_t, uint16_t y_t1, uint16_t x_t, float a)
-* \brief implements an exponential filter
-*  y_t is the current filtered value
-*  x_t is the current raw value
-*  a is the filter parameter (smaller = faster filter ) (0<a<1)
-*
-*  This exponentialFilter is proposed for metrics in the following paper on page 8
-*  http://citeseerx.ist.psu.edu/viewdoc/download?doi=10.1.1.304.7863&rep=rep1&type=pdf
+* \fn static void readRoutingSnapshot(tRoutingSnapshot* snapshot)
+* \brief Copies the published routing decision without blocking. If the metrics task published a new one
+*  in the meantime, the copy is repeated.
 */
-static void exponentialFilter(uint16_t* y_t, uint16_t* x_t, float a)
+static void readRoutingSnapshot(tRoutingSnapshot* snapshot)
 {
-	if(a<0)
-		a=0;
-	if(a>1)
-		a=1;
+	uint32_t sequence;
 
-	*y_t = (uint16_t)(a*((float)*y_t) + ((1-a)*((float)*x_t)));
+	do
+	{
+		sequence = routingSnapshotSequence;
+		MEMORY_BARRIER();
+		*snapshot = routingSnapshot[sequence & 1];
+		MEMORY_BARRIER();
+	} while(sequence != routingSnapshotSequence);
 }
 
 /*!
-* \fn bool calculateMetric_RoundTripTime(uint16_t* roundTripTime, tWirelessPackage* sentPack,tWirelessPackage* receivedPack)
-* \brief calculates the RoundTripTime (RTT) Metric. This is the Time a TestPacket takes to go from the sendre to the receiver
-* and again back to the sender. This metric is roughly twice the latency.
+* \fn static void addTransmittedBytes(uint8_t wirelessLink, uint16_t bytes)
+* \brief Counts the bytes routed to a link for the load balancing of the metrics task (atomic, no semaphore needed)
 */
-static bool calculateMetric_RoundTripTime(uint16_t* roundTripTime, tWirelessPackage* sentPack,tWirelessPackage* receivedPack)
+static void addTransmittedBytes(uint8_t wirelessLink, uint16_t bytes)
 {
-	tTestPackagePayload payloadSentPack, payloadReceivedPack;
-	copyTestPackagePayload(sentPack,&payloadSentPack);
-	copyTestPackagePayload(receivedPack,&payloadReceivedPack);
-
-	if(payloadSentPack.sendTimestamp <= payloadReceivedPack.sendTimestamp)
-	{
-		*roundTripTime = payloadReceivedPack.sendTimestamp-payloadSentPack.sendTimestamp;
-	}
-	else
-	{
-		*roundTripTime = (0xFFFF-payloadSentPack.sendTimestamp)+payloadReceivedPack.sendTimestamp;
-	}
-	return true;
+	__atomic_fetch_add(&nofTransmittedBytesSinceLastTaskCall[wirelessLink], bytes, __ATOMIC_RELAXED);
 }
 
 /*!
-* \fn bool calculateMetric_SenderBasedPacketPair(uint16_t* senderBasedPacketPair, tWirelessPackage* firstReceivedPackage,tWirelessPackage* secondReceivedPackage)
-* \brief calculates the SenderBasesPacketPair (SBPP) Metric. This metric is an estimation of the available maximum Bandwith
+* \fn static int8_t chooseStripingLink(uint16_t bytesToSend, bool* linkCandidates)
+* \brief Chooses one of the candidate links with deficit round robin. Every round, each link gets a quantum of bytes
+*  in proportion to its bandwidth (SBPP) and sends packages as long as its deficit is big enough.
+*  Links whose transmit backlog needs longer than STRIPING_MAX_BACKLOG_MS are skipped, except all candidates are that busy.
+*  The deficit is charged by networkMetrics_chargeLink() once the package is handed to the link.
+* \return number of the link to use, -1 if there is no candidate
 */
-static bool calculateMetric_SenderBasedPacketPair(uint16_t* senderBasedPacketPair, tWirelessPackage* firstReceivedPackage,tWirelessPackage* secondReceivedPackage)
+static int8_t chooseStripingLink(uint16_t bytesToSend, bool* linkCandidates)
 {
-	tTestPackagePayload payloadFirstReceivedPackage, payloadSecondReceivedPackage;
-	copyTestPackagePayload(firstReceivedPackage,&payloadFirstReceivedPackage);
-	copyTestPackagePayload(secondReceivedPackage,&payloadSecondReceivedPackage);
-
-	uint16_t timeDelayBetwennReceivedPackages;
+	static uint8_t currentLink = 0;
+	uint32_t bandwidth[NUMBER_OF_UARTS];
+	uint32_t maxBandwidth = 0;
+	bool linkUsable[NUMBER_OF_UARTS];
+	bool anyLinkUsable = false;
 
-	if(payloadFirstReceivedPackage.sendTimestamp == payloadSecondReceivedPackage.sendTimestamp)
+	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
 	{
-		if(*senderBasedPacketPair !=0)
+		bandwidth[i] = getLinkBandwidth(i);
+		linkUsable[i] = linkCandidates[i] && (bandwidth[i] > 0) && (getBacklogDelay(i) <= STRIPING_MAX_BACKLOG_MS);
+		if(linkUsable[i])
 		{
-			return false;
+			anyLinkUsable = true;
 		}
-		else
+	}
+	if(!anyLinkUsable) //All candidates are busy -> share the load between them anyway
+	{
+		for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+		{
+			linkUsable[i] = linkCandidates[i] && (bandwidth[i] > 0);
+			anyLinkUsable |= linkUsable[i];
+		}
+		if(!anyLinkUsable)
 		{
-			timeDelayBetwennReceivedPackages = 5;
+			return -1;
 		}
 	}
-	else if(payloadFirstReceivedPackage.sendTimestamp <= payloadSecondReceivedPackage.sendTimestamp)
+	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
 	{
-		timeDelayBetwennReceivedPackages = payloadSecondReceivedPackage.sendTimestamp - payloadFirstReceivedPackage.sendTimestamp;
+		if(linkUsable[i] && bandwidth[i] > maxBandwidth)
+		{
+			maxBandwidth = bandwidth[i];
+		}
 	}
-	else
+
+	/* the link with the highest bandwidth gets STRIPING_QUANTUM >= bytesToSend, so one round is always enough */
+	for(int n = 0 ; n <= 2*NUMBER_OF_UARTS ; n++)
 	{
-		timeDelayBetwennReceivedPackages = (0xFFFF-payloadSecondReceivedPackage.sendTimestamp)+payloadFirstReceivedPackage.sendTimestamp;
+		if(linkUsable[currentLink] && stripingDeficit[currentLink] >= bytesToSend)
+		{
+			return currentLink; //charged with networkMetrics_chargeLink() when the package is handed to the link
+		}
+		if(!linkUsable[currentLink])
+		{
+			stripingDeficit[currentLink] = 0; //Unused links don't collect credit
+		}
+		currentLink = (currentLink + 1) % NUMBER_OF_UARTS;
+		if(linkUsable[currentLink])
+		{
+			stripingDeficit[currentLink] += (bandwidth[currentLink] * STRIPING_QUANTUM) / maxBandwidth;
+		}
 	}
-
-	*senderBasedPacketPair = ((sizeof(tWirelessPackage)+sizeof(tTestPackagePayload))*1000)/timeDelayBetwennReceivedPackages;
-
-	return true;
+	return -1;
 }
 
 /*!
-* \fn bool calculateMetric_PacketLossRatio(uint16_t* packetLossRatio)
-* \brief calculates the PacketLossRatio (PLR) Metric. Number (0...100 [%]) which indicates how many packets that are lost
+* \fn static int8_t chooseEarliestInOrderArrivalLink(uint16_t bytesToSend, bool* linkCandidates, uint8_t deviceNr)
+* \brief Estimates for every candidate link when the package would arrive at the receiver:
+*  (transmit backlog + package) / bandwidth + RTT / 2. The package can only be delivered in order after the previous
+*  package of this device, so all links arriving before that are equally good for this package. Of those, the slowest
+*  one is chosen to keep the fast links free for the next packages. If no link is that fast, the earliest arrival wins.
+* \return number of the link to use, -1 if there is no candidate
 */
-static bool calculateMetric_PacketLossRatio(uint16_t* packetLossRatio,uint8_t wirelessNr)
+static int8_t chooseEarliestInOrderArrivalLink(uint16_t bytesToSend, bool* linkCandidates, uint8_t deviceNr)
 {
-	uint16_t nofLostPacks = 0;
-	for(int i = 0 ; i < NOF_PACKS_FOR_PACKET_LOSS_RATIO ; i++)
+	static TickType_t tickTimeExpectedArrivalLastPackage[NUMBER_OF_UARTS];
+	uint32_t lastPackageArrival = 0; /* [ms] from now */
+	int8_t earliestLink = -1, latestLinkBeforeLastPackage = -1;
+	uint32_t earliestArrival = 0, latestArrivalBeforeLastPackage = 0;
+	int8_t chosenLink;
+	uint32_t chosenArrival;
+	TickType_t now = xTaskGetTickCount();
+
+	if((TickType_t)(tickTimeExpectedArrivalLastPackage[deviceNr] - now) < pdMS_TO_TICKS(MAX_EXPECTED_ARRIVAL_MS)) //Previous package not arrived yet
 	{
-		if(packetLossIndicatorForPLR[wirelessNr][i])
-		{
-			nofLostPacks ++;
-		}
+		lastPackageArrival = (tickTimeExpectedArrivalLastPackage[deviceNr] - now) * portTICK_PERIOD_MS;
 	}
-	*packetLossRatio = (100/NOF_PACKS_FOR_PACKET_LOSS_RATIO) * nofLostPacks;
-	return true;
+
+	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+	{
+		uint32_t bandwidth = getLinkBandwidth(i);
+		uint32_t arrival;
+		if(!linkCandidates[i] || bandwidth == 0)
+		{
+			continue;
+		}
+		arrival = ((getBytesWaitingForTx(i) + bytesToSend) * 1000) / bandwidth + RTTfiltered[i] / 2;
+		if(arrival > MAX_EXPECTED_ARRIVAL_MS)
+		{
+			arrival = MAX_EXPECTED_ARRIVAL_MS;
+		}
+		if(earliestLink < 0 || arrival < earliestArrival)
+		{
+			earliestLink = i;
+			earliestArrival = arrival;
+		}
+		if(arrival <= lastPackageArrival && (latestLinkBeforeLastPackage < 0 || arrival > latestArrivalBeforeLastPackage))
+		{
+			latestLinkBeforeLastPackage = i;
+			latestArrivalBeforeLastPackage = arrival;
+		}
+	}
+
+	if(latestLinkBeforeLastPackage >= 0)
+	{
+		chosenLink = latestLinkBeforeLastPackage;
+		chosenArrival = lastPackageArrival; //Gets delivered together with the previous package
+	}
+	else
+	{
+		chosenLink = earliestLink;
+		chosenArrival = earliestArrival;
+	}
+	if(chosenLink >= 0)
+	{
+		tickTimeExpectedArrivalLastPackage[deviceNr] = now + pdMS_TO_TICKS(chosenArrival);
+	}
+	return chosenLink;
+}
+
+/*!
+* \fn static uint32_t getLinkBandwidth(uint8_t wirelessLink)
+* \brief returns the filtered SBPP of the link or its baud rate as long as there is no metric [Byte/s]
+*/
+static uint32_t getLinkBandwidth(uint8_t wirelessLink)
+{
+	if(SBPPfiltered[wirelessLink] != 0)
+	{
+		return SBPPfiltered[wirelessLink];
+	}
+	return config.BaudRatesWirelessConn[wirelessLink] / NOF_BITS_PER_UART_BYTE;
+}
+
+/*!
+* \fn static uint32_t getBytesWaitingForTx(uint8_t wirelessLink)
+* \brief returns the bytes routed to this link which are not sent out yet: the packages waiting for the package handler,
+*  the TX byte queue and the TX FIFO
+*/
+static uint32_t getBytesWaitingForTx(uint8_t wirelessLink)
+{
+	return numberOfBytesInPacksToDisassembleQueue(wirelessLink) + numberOfBytesWaitingForTx(MAX_14830_WIRELESS_SIDE, wirelessLink);
+}
+
+/*!
+* \fn static uint32_t getBacklogDelay(uint8_t wirelessLink)
+* \brief returns how long the bytes routed to this link need to be sent out, see getBytesWaitingForTx() [ms]
+*/
+static uint32_t getBacklogDelay(uint8_t wirelessLink)
+{
+	uint32_t bandwidth = getLinkBandwidth(wirelessLink);
+
+	if(bandwidth == 0)
+	{
+		return MAX_EXPECTED_ARRIVAL_MS;
+	}
+	return (getBytesWaitingForTx(wirelessLink) * 1000) / bandwidth;
+}
+
+/*!
+* \fn static void avoidBackloggedLinks(bool* linksToUse, tRoutingSnapshot* snapshot)
+* \brief Removes the links from linksToUse whose transmit backlog needs longer than MAX_LINK_BACKLOG_MS.
+*  If all chosen links are backlogged, the link with the highest Q which is not backlogged is used instead.
+*  If there is no such link, linksToUse is not changed.
+*/
+static void avoidBackloggedLinks(bool* linksToUse, tRoutingSnapshot* snapshot)
+{
+	bool linkIsBacklogged[NUMBER_OF_UARTS];
+	bool chosenLinkAvailable = false;
+	int8_t alternativeLink = -1;
+
+	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+	{
+		linkIsBacklogged[i] = (getBacklogDelay(i) >= MAX_LINK_BACKLOG_MS);
+		if(linksToUse[i] && !linkIsBacklogged[i])
+		{
+			chosenLinkAvailable = true;
+		}
+		if(!linkIsBacklogged[i] && snapshot->Q[i] != 0 && (alternativeLink < 0 || snapshot->Q[i] > snapshot->Q[alternativeLink]))
+		{
+			alternativeLink = i;
+		}
+	}
+	if(!chosenLinkAvailable && alternativeLink < 0)
+	{
+		return; //All links are backlogged, keep the routing decision
+	}
+	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+	{
+		if(chosenLinkAvailable)
+		{
+			linksToUse[i] = linksToUse[i] && !linkIsBacklogged[i];
+		}
+		else
+		{
+			linksToUse[i] = (i == alternativeLink);
+		}
+	}
+}
+
+/*!
+* \fn  void networkMetrics_getLinksToUse(uint16_t bytesToSend,bool* wirelessLinksToUseParam, uint16_t payloadNr, uint8_t sendTries, uint8_t deviceNr)
+*  in the Bool-Array wirelessLinksToUseParam the wireless links to use get saved. They are choosen by the routingAlgorithm
+*  if priorityData==true, the Data is handled with priority
+*  sendTries is the send attempt of the package (1 = first send), the redundancy is increased with every resend
+*  \return true, if packet has a link to be sent, false if no link is available at the moment
+*/
+bool networkMetrics_getLinksToUse(uint16_t bytesToSend,bool* wirelessLinksToUseParam, uint16_t payloadNr, uint8_t sendTries, uint8_t deviceNr)
+{
+	bool packetSendable = false;
+
+	if(config.RoutingMethode == ROUTING_METHODE_HARD_RULES)
+	{
+		if(config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_1)
+		{
+			routingAlgorithmusHardRulesMethodeVariant1(deviceNr,sendTries);
+		}
+		else if(config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_2)
+		{
+			routingAlgorithmusHardRulesMethodeVariant2(deviceNr,sendTries);
+		}
+		else if(config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_3)
+		{
+			routingAlgorithmusHardRulesMethodeVariant3(deviceNr,sendTries, payloadNr);
+		}
+		for(int i=0 ; i<NUMBER_OF_UARTS ; i++)
+		{
+			wirelessLinksToUseParam[i] = wirelessLinksToUse[i];
+			if(wirelessLinksToUse[i])
+			{
+				packetSendable = true;
+			}
+		}
+	}
+
+	if(config.RoutingMethode == ROUTING_METHODE_METRICS)
+	{
+		tRoutingSnapshot snapshot;
+		readRoutingSnapshot(&snapshot);
+
+		if((config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_4 || config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_5 || config.FecParityGroupSize[deviceNr] > 0) && !snapshot.onlyPrioDeviceCanSend && sendTries <= 1)
+		{
+			//Striping: the package is sent once on one of the links (with FEC, the parity package replaces the redundant copies)
+			int8_t stripingLink;
+			if(config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_5)
+			{
+				stripingLink = chooseEarliestInOrderArrivalLink(bytesToSend, snapshot.wirelessLinksToUse, deviceNr);
+			}
+			else
+			{
+				stripingLink = chooseStripingLink(bytesToSend, snapshot.wirelessLinksToUse);
+			}
+			for(int i=0 ; i<NUMBER_OF_UARTS ; i++)
+			{
+				wirelessLinksToUseParam[i] = (i == stripingLink);
+			}
+			if(stripingLink >= 0)
+			{
+				packetSendable = true;
+			}
+		}
+		else if(!snapshot.onlyPrioDeviceCanSend || config.PrioDevice[deviceNr])
+		{
+			uint8_t numberOfUsedChannels = 0;
+			for(int i=0 ; i<NUMBER_OF_UARTS ; i++)
+			{
+				if(snapshot.wirelessLinksToUse[i])
+				{
+					numberOfUsedChannels++;
+				}
+				wirelessLinksToUseParam[i] = snapshot.wirelessLinksToUse[i];
+			}
+
+			if(config.RoutingMethodeVariant == ROUTING_METHODE_VARIANT_3 && numberOfUsedChannels == 1 && sendTries>1)
+			{
+				for(int i=0 ; i<NUMBER_OF_UARTS ; i++)
+				{
+					if(i == snapshot.sortedQindexes[0] || i == snapshot.sortedQindexes[1])
+					{
+						wirelessLinksToUseParam[i] = true;
+					}
+				}
+			}
+
+			if(!snapshot.onlyPrioDeviceCanSend)
+			{
+				avoidBackloggedLinks(wirelessLinksToUseParam, &snapshot);
+			}
+
+			for(int i=0 ; i<NUMBER_OF_UARTS ; i++)
+			{
+				if(wirelessLinksToUseParam[i])
+				{
+					packetSendable = true;
+				}
+			}
+		}
+		else
+		{
+			for(int i=0 ; i<NUMBER_OF_UARTS ; i++)
+			{
+				wirelessLinksToUseParam[i] = false;
+			}
+		}
+	}
+	return packetSendable;
+}
+
+/*!
+* \fn bool networkMetrics_getParityLinkToUse(uint16_t bytesToSend, bool* wirelessLinksToUseParam, uint8_t deviceNr)
+* \brief Chooses one link for a FEC parity package. The parity package is striped over the links of the last routing
+*  decision like the data packages of its group, so it is mostly sent on another link than most of them.
+*  \return true, if packet has a link to be sent, false if no link is available at the moment
+*/
+bool networkMetrics_getParityLinkToUse(uint16_t bytesToSend, bool* wirelessLinksToUseParam, uint8_t deviceNr)
+{
+	bool packetSendable = false;
+	int8_t parityLink = -1;
+	tRoutingSnapshot snapshot;
+
+	readRoutingSnapshot(&snapshot);
+	if(!snapshot.onlyPrioDeviceCanSend || config.PrioDevice[deviceNr])
+	{
+		parityLink = chooseStripingLink(bytesToSend, snapshot.wirelessLinksToUse);
+	}
+	for(int i=0 ; i<NUMBER_OF_UARTS ; i++)
+	{
+		wirelessLinksToUseParam[i] = (i == parityLink);
+	}
+	if(parityLink >= 0)
+	{
+		packetSendable = true;
+	}
+	return packetSendable;
+}
+
+/*!
+* \fn void networkMetrics_chargeLink(uint8_t wirelessLink, uint16_t bytesSent)
+* \brief Charges a package routed with networkMetrics_getLinksToUse() or networkMetrics_getParityLinkToUse() to the link
+*  once it is handed to the link: counts the bytes for the load balancing and the striping deficit.
+*  The routing itself charges nothing, so a deferred package can be routed again. Only called by the network handler.
+*/
+void networkMetrics_chargeLink(uint8_t wirelessLink, uint16_t bytesSent)
+{
+	if(config.RoutingMethode != ROUTING_METHODE_METRICS || wirelessLink >= NUMBER_OF_UARTS)
+	{
+		return;
+	}
+	addTransmittedBytes(wirelessLink, bytesSent);
+	stripingDeficit[wirelessLink] = (stripingDeficit[wirelessLink] > bytesSent) ? stripingDeficit[wirelessLink] - bytesSent : 0;
+}
+
+
+/*!
+* \fn void exponentialFilter(tFixedPoint* y_fixed, uint16_t* y_t, uint16_t* x_t, tFixedPoint a)
+* \brief implements an exponential filter in Q16.16 fixed point
+*  y_fixed is the filter state, y_t its value rounded to an integer
+*  x_t is the current raw value
+*  a is the filter parameter (smaller = faster filter ) (0<=a<=FIXED_POINT_ONE)
+*  The state keeps the fraction, so small raw changes are not lost by truncating y_t on every call
+*
+*  This exponentialFilter is proposed for metrics in the following paper on page 8
+*  http://citeseerx.ist.psu.edu/viewdoc/download?doi=10.1.1.304.7863&rep=rep1&type=pdf
+*/
+static void exponentialFilter(tFixedPoint* y_fixed, uint16_t* y_t, uint16_t* x_t, tFixedPoint a)
+{
+	*y_fixed = fixedPoint_exponentialFilter(*y_fixed, fixedPoint_fromInt(*x_t), a);
+	*y_t = fixedPoint_toUint16(*y_fixed);
+}
+
+/*!
+* \fn bool calculateMetric_RoundTripTime(uint16_t* roundTripTime, uint16_t sendTime, uint16_t arrivalTime)
+* \brief calculates the RoundTripTime (RTT) Metric. This is the Time a TestPacket takes to go from the sendre to the receiver
+* and again back to the sender. This metric is roughly twice the latency.
+*/
+static bool calculateMetric_RoundTripTime(uint16_t* roundTripTime, uint16_t sendTime, uint16_t arrivalTime)
+{
+	if(sendTime <= arrivalTime)
+	{
+		*roundTripTime = arrivalTime-sendTime;
+	}
+	else
+	{
+		*roundTripTime = (0xFFFF-sendTime)+arrivalTime;
+	}
+	return true;
+}
+
+/*!
+* \fn static void addToProbeRecord(tWirelessPackage* testPackage)
+* \brief Stores a sent or returned test package in the record of its probe. All test packages of a probe carry
+*  the probe number in packNr, so the record is found directly at packNr % PROBE_NOF_RECORDS.
+*  A sent first test package starts a new record. The RTT is measured as soon as the first pair returned,
+*  the bandwidth when all sent test packages returned.
+*/
+static void addToProbeRecord(tWirelessPackage* testPackage)
+{
+	uint8_t wirelessLink = testPackage->devNum;
+	tProbeRecord* record;
+	tTestPackagePayload payload;
+	uint16_t indexInTrain;
+
+	if(wirelessLink >= NUMBER_OF_UARTS)
+	{
+		return;
+	}
+	record = &probeRecords[wirelessLink][testPackage->packNr % PROBE_NOF_RECORDS];
+	copyTestPackagePayload(testPackage,&payload);
+
+	if(!payload.returned && testPackage->packType == PACK_TYPE_NETWORK_TEST_PACKAGE_FIRST)
+	{
+		if(record->inUse)
+		{
+			finishProbe(wirelessLink, record); /* more than PROBE_NOF_RECORDS probes outstanding, the oldest counts as timed out */
+		}
+		record->probeNr = testPackage->packNr;
+		record->firstPayloadNr = testPackage->payloadNr;
+		record->sentMask = 0;
+		record->receivedMask = 0;
+		record->inUse = true;
+
+		newestProbeNr[wirelessLink] = testPackage->packNr;
+		if((uint16_t)(newestProbeNr[wirelessLink] - oldestProbeNr[wirelessLink]) >= PROBE_NOF_RECORDS)
+		{
+			oldestProbeNr[wirelessLink] = newestProbeNr[wirelessLink] - (PROBE_NOF_RECORDS - 1);
+		}
+	}
+	if(!record->inUse || record->probeNr != testPackage->packNr)
+	{
+		return; /* probe already timed out or its first test package was not stored */
+	}
+	indexInTrain = testPackage->payloadNr - record->firstPayloadNr;
+	if(indexInTrain >= PROBE_TRAIN_MAX_LENGTH)
+	{
+		return;
+	}
+
+	if(!payload.returned)
+	{
+		record->sendTime[indexInTrain] = payload.sendTimestamp;
+		record->sentMask |= (1 << indexInTrain);
+	}
+	else if((record->sentMask & (1 << indexInTrain)) && !(record->receivedMask & (1 << indexInTrain)))
+	{
+		record->arrivalTime[indexInTrain] = payload.sendTimestamp; /* the transport handler replaced it by the arrival time */
+		record->frameSize[indexInTrain] = packageHandler_getWirelessFrameSize(testPackage);
+		record->receivedMask |= (1 << indexInTrain);
+
+		if(indexInTrain < 2)
+		{
+			updatePacketLossRatioPacketOK(wirelessLink);
+			if((record->receivedMask & 0x03) == 0x03) /* first pair returned */
+			{
+				pairMeasured[wirelessLink] = true;
+				probePending[wirelessLink] = false;
+				timeStampLastValidMetric[wirelessLink] = xTaskGetTickCount();
+				for(int i = 0; i < 2; i++)
+				{
+					calculateMetric_RoundTripTime(&RTTraw[wirelessLink], record->sendTime[i], record->arrivalTime[i]);
+					exponentialFilter(&RTTfilteredFixed[wirelessLink],&RTTfiltered[wirelessLink],&RTTraw[wirelessLink],rttFilterParam);
+				}
+			}
+		}
+		if(record->receivedMask == record->sentMask)
+		{
+			finishProbe(wirelessLink, record);
+		}
+	}
+}
+
+/*!
+* \fn static void finishProbe(uint8_t wirelessLink, tProbeRecord* record)
+* \brief Completes a probe which returned completely or timed out: test packages of the first pair which did not
+*  return count as lost, the bandwidth is measured with the returned test packages. Frees the record.
+*/
+static void finishProbe(uint8_t wirelessLink, tProbeRecord* record)
+{
+	for(int i = 0; i < 2; i++)
+	{
+		if((record->sentMask & (1 << i)) && !(record->receivedMask & (1 << i)))
+		{
+			updatePacketLossRatioPacketNOK(wirelessLink);
+		}
+	}
+	if(calculateMetric_PacketTrainBandwidth(&SBPPraw[wirelessLink], record))
+	{
+		exponentialFilter(&SBPPfilteredFixed[wirelessLink],&SBPPfiltered[wirelessLink],&SBPPraw[wirelessLink],sbppFilterParam);
+		bandwidthMeasured[wirelessLink] = true;
+	}
+	record->inUse = false;
+}
+
+/*!
+* \fn static void expireProbes(uint8_t wirelessLink)
+* \brief Finishes the probes which are outstanding for longer than TIMEOUT_TEST_PACKET_RETURN.
+*  Probes are sent in the order of their number, so only the oldest outstanding ones need to be checked.
+*/
+static void expireProbes(uint8_t wirelessLink)
+{
+	while((uint16_t)(newestProbeNr[wirelessLink] - oldestProbeNr[wirelessLink]) < PROBE_NOF_RECORDS)
+	{
+		tProbeRecord* record = &probeRecords[wirelessLink][oldestProbeNr[wirelessLink] % PROBE_NOF_RECORDS];
+		if(record->inUse && record->probeNr == oldestProbeNr[wirelessLink])
+		{
+			if(getTimespan(record->sendTime[0]) < TIMEOUT_TEST_PACKET_RETURN)
+			{
+				break;
+			}
+			finishProbe(wirelessLink, record);
+		}
+		oldestProbeNr[wirelessLink]++;
+	}
+}
+
+/*!
+* \fn static bool calculateMetric_PacketTrainBandwidth(uint16_t* bandwidth, tProbeRecord* record)
+* \brief Calculates the bandwidth [Byte/s] of the link from the dispersion of the returned test packages:
+*  frame size on the link divided by the median time between two returned test packages.
+*  Lost test packages in between are skipped, the time is divided by the number of packages it spans.
+*  If the median is below the tick resolution, the time of the whole train is used (at least one tick),
+*  which gives a lower bound of the bandwidth.
+* \return false if less than two test packages of the train returned
+*/
+static bool calculateMetric_PacketTrainBandwidth(uint16_t* bandwidth, tProbeRecord* record)
+{
+	uint32_t dispersion[PROBE_TRAIN_MAX_LENGTH]; /* [us] per test package */
+	uint32_t frameBytes = 0;
+	uint32_t result;
+	uint8_t nofDispersions = 0;
+	int8_t firstReceived = -1, previousReceived = -1;
+
+	for(int i = 0; i < PROBE_TRAIN_MAX_LENGTH; i++)
+	{
+		if((record->receivedMask & (1 << i)) == 0)
+		{
+			continue;
+		}
+		if(previousReceived < 0)
+		{
+			firstReceived = i;
+		}
+		else
+		{
+			uint16_t gap = record->arrivalTime[i] - record->arrivalTime[previousReceived];
+			dispersion[nofDispersions++] = ((uint32_t)gap * portTICK_PERIOD_MS * 1000) / (i - previousReceived);
+			frameBytes += record->frameSize[i];
+		}
+		previousReceived = i;
+	}
+	if(nofDispersions == 0)
+	{
+		return false;
+	}
+
+	/* sort to get the median */
+	for(int i = 1; i < nofDispersions; i++)
+	{
+		uint32_t value = dispersion[i];
+		int j = i - 1;
+		while(j >= 0 && dispersion[j] > value)
+		{
+			dispersion[j + 1] = dispersion[j];
+			j--;
+		}
+		dispersion[j + 1] = value;
+	}
+
+	uint32_t medianDispersion = (dispersion[(nofDispersions - 1) / 2] + dispersion[nofDispersions / 2]) / 2;
+	if(medianDispersion > 0)
+	{
+		result = ((frameBytes / nofDispersions) * 1000000) / medianDispersion;
+	}
+	else
+	{
+		uint16_t span = record->arrivalTime[previousReceived] - record->arrivalTime[firstReceived];
+		if(span == 0)
+		{
+			span = 1;
+		}
+		result = (frameBytes * 1000) / ((uint32_t)span * portTICK_PERIOD_MS);
+	}
+
+	*bandwidth = (result > 0xFFFF) ? 0xFFFF : (uint16_t)result;
+	return true;
+}
+
+/*!
+* \fn bool calculateMetric_PacketLossRatio(uint16_t* packetLossRatio)
+* \brief calculates the PacketLossRatio (PLR) Metric. Number (0...1000 [per mille]) which indicates how many packets that are lost.
+*  Every test package and acknowledged/lost data package counts with a weight that halves every config.PlrHalfLife
+*/
+static bool calculateMetric_PacketLossRatio(uint16_t* packetLossRatio,uint8_t wirelessNr)
+{
+	tFixedPoint lossRatio = fixedPoint_div(plrLostWeight[wirelessNr], plrSampleWeight[wirelessNr]); /* 0 without samples */
+
+	*packetLossRatio = fixedPoint_toUint16(fixedPoint_mul(lossRatio, fixedPoint_fromInt(1000)));
+	return true;
+}
+
+/*!
+* \fn static void updatePacketLossRatioPacketNOK(uint8_t wirelessNr)
+* \brief A test package or data package sent on the link was lost
+*/
+static void updatePacketLossRatioPacketNOK(uint8_t wirelessNr)
+{
+	addPacketLossSample(wirelessNr, true);
+}
+
+/*!
+* \fn static void updatePacketLossRatioPacketOK(uint8_t wirelessNr)
+* \brief A test package returned or a data package sent on the link was acknowledged
+*/
+static void updatePacketLossRatioPacketOK(uint8_t wirelessNr)
+{
+	addPacketLossSample(wirelessNr, false);
+}
+
+/*!
+* \fn static void addPacketLossSample(uint8_t wirelessNr, bool packetLost)
+* \brief Adds a package to the time weighted packet loss ratio: the weights of the earlier packages are
+*  halved every config.PlrHalfLife ms, the new package counts with weight 1
+*/
+static void addPacketLossSample(uint8_t wirelessNr, bool packetLost)
+{
+	TickType_t now = xTaskGetTickCount();
+	uint32_t elapsedMs = (now - tickTimeLastPlrSample[wirelessNr]) * portTICK_PERIOD_MS;
+	uint32_t nofHalfLives = elapsedMs / config.PlrHalfLife;
+	tFixedPoint decay = 0; /* 2^-16 and less is 0 in Q16.16 */
+
+	if(nofHalfLives <= 16)
+	{
+		/* the remainder stays below PLR_HALF_LIFE, so fixedPoint_fromInt() does not saturate */
+		decay = fixedPoint_pow2Neg(fixedPoint_add(fixedPoint_fromInt(nofHalfLives),
+				fixedPoint_div(fixedPoint_fromInt(elapsedMs % config.PlrHalfLife), plrHalfLife)));
+	}
+
+	plrLostWeight[wirelessNr] = fixedPoint_mul(plrLostWeight[wirelessNr], decay);
+	plrSampleWeight[wirelessNr] = fixedPoint_add(fixedPoint_mul(plrSampleWeight[wirelessNr], decay), FIXED_POINT_ONE);
+	if(packetLost)
+	{
+		plrLostWeight[wirelessNr] = fixedPoint_add(plrLostWeight[wirelessNr], FIXED_POINT_ONE);
+	}
+	tickTimeLastPlrSample[wirelessNr] = now;
+}
+
+/*!
+* \fn static void predictQ(uint8_t wirelessLink)
+* \brief Updates the trends of RTT, PLR and the rate of Golay corrected words of the link and calculates Qpredicted,
+*  the Q expected in config.TrendHorizon ms. A rising Golay error rate announces package losses before they happen,
+*  so its projected rise counts as additional loss (scaled with SCALING_DIVIDER_GOLAY_FOR_PLR). The Golay trend restarts
+*  when the link was idle for an interval. Qpredicted = Q if config.TrendHorizon = 0.
+*/
+static void predictQ(uint8_t wirelessLink)
+{
+	static long unsigned int lastNofGolayDecodedWords[NUMBER_OF_UARTS], lastNofGolayCorrectedWords[NUMBER_OF_UARTS];
+	long unsigned int nofDecodedWords = numberOfGolayDecodedWords[wirelessLink] - lastNofGolayDecodedWords[wirelessLink];
+	long unsigned int nofCorrectedWords = numberOfGolayCorrectedWords[wirelessLink] - lastNofGolayCorrectedWords[wirelessLink];
+	uint32_t nofIntervals = config.TrendHorizon / config.NetworkMetricsTaskInterval;
+	uint32_t projectedRTT, projectedPLR;
+
+	lastNofGolayDecodedWords[wirelessLink] += nofDecodedWords;
+	lastNofGolayCorrectedWords[wirelessLink] += nofCorrectedWords;
+
+	updateTrend(&rttTrend[wirelessLink], RTTraw[wirelessLink]);
+	updateTrend(&plrTrend[wirelessLink], PLR[wirelessLink]);
+	if(nofDecodedWords > 0)
+	{
+		updateTrend(&golayErrorTrend[wirelessLink], (uint16_t)((nofCorrectedWords * 1000) / nofDecodedWords)); /* [per mille] */
+	}
+	else
+	{
+		golayErrorTrend[wirelessLink].slope = 0; /* idle link, the trend of the last traffic is not valid anymore */
+		golayErrorTrend[wirelessLink].initialized = false;
+	}
+
+	if(nofIntervals == 0)
+	{
+		Qpredicted[wirelessLink] = Q[wirelessLink];
+		return;
+	}
+	/* only rising trends are projected, the metrics of a link which gets better are taken when they are measured */
+	projectedRTT = RTTfiltered[wirelessLink] + getTrendRise(&rttTrend[wirelessLink], nofIntervals);
+	projectedPLR = PLR[wirelessLink] + getTrendRise(&plrTrend[wirelessLink], nofIntervals) +
+	               getTrendRise(&golayErrorTrend[wirelessLink], nofIntervals) / SCALING_DIVIDER_GOLAY_FOR_PLR;
+	if(projectedRTT > 0xFFFF)
+	{
+		projectedRTT = 0xFFFF;
+	}
+	if(projectedPLR > 1000)
+	{
+		projectedPLR = 1000;
+	}
+	calculateQ(SBPPfiltered[wirelessLink],(uint16_t)projectedRTT,(uint16_t)projectedPLR,CPP[wirelessLink],&Qpredicted[wirelessLink]);
 }
 
-static void updatePacketLossRatioPacketNOK(uint8_t wirelessNr)
+/*!
+* \fn static void updateTrend(tTrend* trend, uint16_t sample)
+* \brief Holt's double exponential smoothing, called once per metrics task interval:
+*  level = a * sample + (1 - a) * (level + slope), slope = b * (level - previous level) + (1 - b) * slope
+*  with a = TREND_LEVEL_PARAM and b = TREND_SLOPE_PARAM
+*/
+static void updateTrend(tTrend* trend, uint16_t sample)
 {
-	packetLossIndicatorForPLR[wirelessNr][indexOfPLRarray[wirelessNr]] = true;
-	indexOfPLRarray[wirelessNr] ++;
-	indexOfPLRarray[wirelessNr] %= NOF_PACKS_FOR_PACKET_LOSS_RATIO;
+	int32_t previousLevel = trend->level;
+	int64_t scaledSample = (int64_t)sample * TREND_SCALE;
+
+	if(!trend->initialized)
+	{
+		trend->level = (int32_t)scaledSample;
+		trend->slope = 0;
+		trend->initialized = true;
+		return;
+	}
+	trend->level = (int32_t)((TREND_LEVEL_PARAM * scaledSample + (int64_t)(1000 - TREND_LEVEL_PARAM) * ((int64_t)trend->level + trend->slope)) / 1000);
+	trend->slope = (int32_t)((TREND_SLOPE_PARAM * ((int64_t)trend->level - previousLevel) + (int64_t)(1000 - TREND_SLOPE_PARAM) * trend->slope) / 1000);
 }
 
 /*!
-* \fn bool static void updatePacketLossRatio(void)
-* \brief updates the ringbuffer for the packet loss Ratio metric. Needs to be called at every insertion of a received test packet into the packet buffer
+* \fn static uint16_t getTrendRise(tTrend* trend, uint32_t nofIntervals)
+* \brief Returns how much the metric rises within nofIntervals metrics task intervals (nofIntervals * slope), 0 if it falls
 */
-static void updatePacketLossRatioPacketOK(uint8_t wirelessNr)
+static uint16_t getTrendRise(tTrend* trend, uint32_t nofIntervals)
 {
-	packetLossIndicatorForPLR[wirelessNr][indexOfPLRarray[wirelessNr]] = false;
-	indexOfPLRarray[wirelessNr] ++;
-	indexOfPLRarray[wirelessNr] %= NOF_PACKS_FOR_PACKET_LOSS_RATIO;
+	int64_t rise = ((int64_t)trend->slope * nofIntervals) / TREND_SCALE;
+
+	if(rise < 0)
+	{
+		return 0;
+	}
+	if(rise > 0xFFFF)
+	{
+		return 0xFFFF;
+	}
+	return (uint16_t)rise;
 }
 
 /*!
 * \fn void calculateQ(uint16_t SBPP,uint16_t RTT,uint16_t PLR,uint16_t CPP, uint16_t* Q)
 * \brief calculates the quality Factor out of the metrics
+*  Q = (SBPP * SCALING_FACTOR_SBPP_FOR_Q) / (RTT/SCALING_DIVIDER_RTT_FOR_Q * max(PLR/SCALING_DIVIDER_PLR_FOR_Q, 1) * CPP)
+*  Calculated in Q16.16 fixed point with saturation: the scaled terms keep their fraction and
+*  a link without RTT or CPP gets Q = 0 instead of a division by zero.
 */
 static void calculateQ(uint16_t SBPP,uint16_t RTT,uint16_t PLR,uint16_t CPP, uint16_t* Q)
 {
+	tFixedPoint scaledRTT = fixedPoint_fromInt(RTT) / SCALING_DIVIDER_RTT_FOR_Q;
+	tFixedPoint scaledPLR = fixedPoint_fromInt(PLR) / SCALING_DIVIDER_PLR_FOR_Q;
+	tFixedPoint divisor;
 
-	SBPP = SBPP * SCALING_FACTOR_SBPP_FOR_Q;
-	RTT = RTT / SCALING_DIVIDER_RTT_FOR_Q;
-	PLR = PLR / SCALING_DIVIDER_PLR_FOR_Q;
+	if(scaledPLR < FIXED_POINT_ONE)
+		scaledPLR = FIXED_POINT_ONE;
 
-	if(PLR == 0)
-		PLR = 1;
+	if(RTT == 0 || CPP == 0)
+	{
+		*Q = 0; /* no valid metric */
+		return;
+	}
 
-	*Q = SBPP / (RTT*PLR*CPP);
+	divisor = fixedPoint_mul(fixedPoint_mul(scaledRTT, scaledPLR), fixedPoint_fromInt(CPP));
+	/* scale SBPP after the division, SBPP * SCALING_FACTOR_SBPP_FOR_Q does not fit into the integer part */
+	*Q = fixedPoint_toUint16(fixedPoint_mul(fixedPoint_div(fixedPoint_fromInt(SBPP), divisor), fixedPoint_fromInt(SCALING_FACTOR_SBPP_FOR_Q)));
 }
 
 /*!
@@ -982,175 +1729,134 @@ uint16_t networkMetrics_getResendDelayWirelessConn(void)
 }
 
 /*!
-* \fn bool findPacketPairInBuffer(tWirelessPackage* sentPack1 , tWirelessPackage* sentPack2, tWirelessPackage* receivedPack1, tWirelessPackage* receivedPack2,uint16_t deviceID, uint16_t startPairNr)
-* \brief finds test packets from a single packet pair out of the packet buffer
+* \fn uint32_t networkMetrics_getBandwidth(void)
+* \brief estimates the bandwidth of all wireless links together in bytes per second.
+*  If no metrics are available, the configured baud rates are used.
+* \return bandwidth [Byte/s]
 */
-static bool findPacketPairInBuffer(tWirelessPackage* sentPack1 , tWirelessPackage* sentPack2, tWirelessPackage* receivedPack1, tWirelessPackage* receivedPack2,uint16_t deviceID, uint16_t startPairNr)
+uint32_t networkMetrics_getBandwidth(void)
 {
-	typedef enum eFindPacketPairState{ FIND_SENT_PACK1, FIND_SENT_PACK2, FIND_RECEIVED_PACK1, FIND_RECEIVED_PACK2,FOUND_ALL,FOUND_NOT_ALL} eFindPacketPairState;
-	eFindPacketPairState state = FIND_SENT_PACK1;
-	tWirelessPackage tempPack;
-	tTestPackagePayload payload;
-	uint16_t latecy;
-	uint64_t timeStampSent1, timeStampSent2, timeStampRec1,timeStampRec2;
-	while(state!= FOUND_ALL && state!=FOUND_NOT_ALL)
+	uint32_t bandwidth = 0;
+
+	if(config.RoutingMethode == ROUTING_METHODE_METRICS && (config.UseProbingPacksWlConn[0] || config.UseProbingPacksWlConn[1] || config.UseProbingPacksWlConn[2] || config.UseProbingPacksWlConn[3]))
 	{
-		switch (state)
+		for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+		{
+			if(Q[i] != 0)
 			{
-				case FIND_SENT_PACK1:
-					if(packageBuffer_getPackageWithTimeStamp(&testPackageBuffer[deviceID],&tempPack,startPairNr,&latecy,&timeStampSent1))
-					{
-						copyTestPackagePayload(&tempPack,&payload);
-						if(tempPack.packType == PACK_TYPE_NETWORK_TEST_PACKAGE_FIRST  &&  !payload.returned)
-						{
-							*sentPack1 = tempPack;
-							state = FIND_SENT_PACK2;
-						}
-						else
-						{
-							packageBuffer_putNotUniqueWithTimestamp(&testPackageBuffer[deviceID],&tempPack,timeStampSent1);
-							vPortFree(tempPack.payload);
-							tempPack.payload = NULL;
-							state = FOUND_NOT_ALL;
-						}
-					}
-					else
-					{
-						state = FOUND_NOT_ALL;
-					}
-					break;
-				case FIND_SENT_PACK2:
-					if(packageBuffer_getPackageWithTimeStamp(&testPackageBuffer[deviceID],&tempPack,startPairNr+1,&latecy,&timeStampSent2))
-					{
-						copyTestPackagePayload(&tempPack,&payload);
-						if(tempPack.packType == PACK_TYPE_NETWORK_TEST_PACKAGE_SECOND  &&  !payload.returned)
-						{
-							*sentPack2 = tempPack;
-							state = FIND_RECEIVED_PACK1;
-						}
-						else
-						{
-							packageBuffer_putNotUniqueWithTimestamp(&testPackageBuffer[deviceID],sentPack1,timeStampSent1);
-							vPortFree(sentPack1->payload);
-							sentPack1->payload = NULL;
-
-							packageBuffer_putNotUniqueWithTimestamp(&testPackageBuffer[deviceID],&tempPack,timeStampSent2);
-							vPortFree(tempPack.payload);
-							tempPack.payload = NULL;
-							state = FOUND_NOT_ALL;
-						}
-					}
-					else
-					{
-						packageBuffer_putNotUniqueWithTimestamp(&testPackageBuffer[deviceID],sentPack1,timeStampSent1);
-						vPortFree(sentPack1->payload);
-						sentPack1->payload = NULL;
+				bandwidth += SBPPfiltered[i];
+			}
+		}
+	}
 
-						state = FOUND_NOT_ALL;
-					}
-					break;
-				case FIND_RECEIVED_PACK1:
-					if(packageBuffer_getPackageWithTimeStamp(&testPackageBuffer[deviceID],&tempPack,startPairNr,&latecy,&timeStampRec1))
-					{
-						copyTestPackagePayload(&tempPack,&payload);
-						if(tempPack.packType == PACK_TYPE_NETWORK_TEST_PACKAGE_FIRST  &&  payload.returned)
-						{
-							*receivedPack1 = tempPack;
-							state = FIND_RECEIVED_PACK2;
-						}
-						else
-						{
-							packageBuffer_putNotUniqueWithTimestamp(&testPackageBuffer[deviceID],sentPack1,timeStampSent1);
-							vPortFree(sentPack1->payload);
-							sentPack1->payload = NULL;
-
-							packageBuffer_putNotUniqueWithTimestamp(&testPackageBuffer[deviceID],sentPack2,timeStampSent2);
-							vPortFree(sentPack2->payload);
-							sentPack2->payload = NULL;
-
-							packageBuffer_putNotUniqueWithTimestamp(&testPackageBuffer[deviceID],&tempPack,timeStampRec1);
-							vPortFree(tempPack.payload);
-							tempPack.payload = NULL;
-							state = FOUND_NOT_ALL;
-						}
-					}
-					else
-					{
-						packageBuffer_putNotUniqueWithTimestamp(&testPackageBuffer[deviceID],sentPack1,timeStampSent1);
-						vPortFree(sentPack1->payload);
-						sentPack1->payload = NULL;
+	if(bandwidth == 0) //No metrics available yet -> use the configured baud rates
+	{
+		for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+		{
+			bandwidth += config.BaudRatesWirelessConn[i] / NOF_BITS_PER_UART_BYTE;
+		}
+	}
+	return bandwidth;
+}
 
-						packageBuffer_putNotUniqueWithTimestamp(&testPackageBuffer[deviceID],sentPack2,timeStampSent2);
-						vPortFree(sentPack2->payload);
-						sentPack2->payload = NULL;
+/*!
+* \fn uint16_t networkMetrics_getPacketLossRatio(void)
+* \brief returns the highest packet loss ratio of the links which are used at the moment (of all links if none is used).
+*  Only measured with ROUTING_METHODE = 2 and probing packs, 0 otherwise.
+* \return packet loss ratio [per mille]
+*/
+uint16_t networkMetrics_getPacketLossRatio(void)
+{
+	uint16_t packetLossRatio = 0;
+	bool anyLinkUsed = false;
+	tRoutingSnapshot snapshot;
 
-						state = FOUND_NOT_ALL;
-					}
-					break;
-				case FIND_RECEIVED_PACK2:
-					if(packageBuffer_getPackageWithTimeStamp(&testPackageBuffer[deviceID],&tempPack,startPairNr+1,&latecy,&timeStampRec2))
-					{
-						copyTestPackagePayload(&tempPack,&payload);
-						if(tempPack.packType == PACK_TYPE_NETWORK_TEST_PACKAGE_SECOND  &&  payload.returned)
-						{
-							*receivedPack2 = tempPack;
-							state = FOUND_ALL;
-						}
-						else
-						{
-							packageBuffer_putNotUniqueWithTimestamp(&testPackageBuffer[deviceID],sentPack1,timeStampSent1);
-							vPortFree(sentPack1->payload);
-							sentPack1->payload = NULL;
-
-							packageBuffer_putNotUniqueWithTimestamp(&testPackageBuffer[deviceID],sentPack2,timeStampSent2);
-							vPortFree(sentPack2->payload);
-							sentPack2->payload = NULL;
-
-							packageBuffer_putNotUniqueWithTimestamp(&testPackageBuffer[deviceID],receivedPack1,timeStampRec1);
-							vPortFree(receivedPack1->payload);
-							receivedPack1->payload = NULL;
-
-							packageBuffer_putNotUniqueWithTimestamp(&testPackageBuffer[deviceID],&tempPack,timeStampRec2);
-							vPortFree(tempPack.payload);
-							tempPack.payload = NULL;
-							state = FOUND_NOT_ALL;
-						}
-					}
-					else
-					{
-						packageBuffer_putNotUniqueWithTimestamp(&testPackageBuffer[deviceID],sentPack1,timeStampSent1);
-						vPortFree(sentPack1->payload);
-						sentPack1->payload = NULL;
+	if(config.RoutingMethode != ROUTING_METHODE_METRICS)
+	{
+		return 0;
+	}
+	readRoutingSnapshot(&snapshot);
+	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+	{
+		anyLinkUsed |= snapshot.wirelessLinksToUse[i];
+	}
+	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+	{
+		if((snapshot.wirelessLinksToUse[i] || !anyLinkUsed) && config.UseProbingPacksWlConn[i] && PLR[i] > packetLossRatio)
+		{
+			packetLossRatio = PLR[i];
+		}
+	}
+	return packetLossRatio;
+}
 
-						packageBuffer_putNotUniqueWithTimestamp(&testPackageBuffer[deviceID],sentPack2,timeStampSent2);
-						vPortFree(sentPack2->payload);
-						sentPack2->payload = NULL;
+/*!
+* \fn void networkMetrics_getSnapshot(tLinkMetrics out[NUMBER_OF_UARTS])
+* \brief Copies the metrics of all wireless links as published with the last routing decision.
+*  Does not block, can be called from any task.
+*/
+void networkMetrics_getSnapshot(tLinkMetrics out[NUMBER_OF_UARTS])
+{
+	uint32_t sequence;
 
-						packageBuffer_putNotUniqueWithTimestamp(&testPackageBuffer[deviceID],receivedPack1,timeStampRec1);
-						vPortFree(receivedPack1->payload);
-						receivedPack1->payload = NULL;
+	do
+	{
+		sequence = routingSnapshotSequence;
+		MEMORY_BARRIER();
+		for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+		{
+			out[i] = linkMetricsSnapshot[sequence & 1][i];
+		}
+		MEMORY_BARRIER();
+	} while(sequence != routingSnapshotSequence);
 
-						state = FOUND_NOT_ALL;
-					}
-					break;
-				default:
-					state = FOUND_NOT_ALL;
-					break;
-			}
+	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+	{
+		uint32_t age = (xTaskGetTickCount() - timeStampLastValidMetric[i]) * portTICK_PERIOD_MS; /* 32 bit, read atomically */
+		out[i].lastUpdateAge = (age > 0xFFFF) ? 0xFFFF : (uint16_t)age;
 	}
+}
+
+/*!
+* \fn uint32_t networkMetrics_getRoutingSequence(void)
+* \brief returns a counter which changes every time the metrics task publishes a new routing decision
+*/
+uint32_t networkMetrics_getRoutingSequence(void)
+{
+	return routingSnapshotSequence;
+}
+
+/*!
+* \fn uint32_t networkMetrics_getBandwidthDelayProduct(void)
+* \brief estimates how many bytes can be in flight on all wireless links together (bandwidth * RTT).
+*  If no metrics are available, the configured baud rates and RESEND_DELAY_WIRELESS_CONN are used.
+* \return bytes which can be in flight
+*/
+uint32_t networkMetrics_getBandwidthDelayProduct(void)
+{
+	uint32_t bandwidthDelayProduct = 0;
 
-	if(state == FOUND_ALL)
+	if(config.RoutingMethode == ROUTING_METHODE_METRICS && (config.UseProbingPacksWlConn[0] || config.UseProbingPacksWlConn[1] || config.UseProbingPacksWlConn[2] || config.UseProbingPacksWlConn[3]))
 	{
-		return true;
+		for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+		{
+			if(Q[i] != 0)
+			{
+				bandwidthDelayProduct += ((uint32_t)SBPPfiltered[i] * RTTfiltered[i]) / 1000;
+			}
+		}
 	}
-	else
+
+	if(bandwidthDelayProduct == 0) //No metrics available yet -> use the configured baud rates
 	{
-		return false;
+		for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+		{
+			bandwidthDelayProduct += ((uint32_t)(config.BaudRatesWirelessConn[i] / NOF_BITS_PER_UART_BYTE) * config.ResendDelayWirelessConn) / 1000;
+		}
 	}
+	return bandwidthDelayProduct;
 }
 
-
-
 /*!
 * \fn void generateTestPacketPairRequest(void)
 * \brief This function initializes the array of queues
@@ -1158,23 +1864,114 @@ static bool findPacketPairInBuffer(tWirelessPackage* sentPack1 , tWirelessPackag
 static BaseType_t  generateTestPacketPairRequest(void)
 {
 	static bool request = true;
+	static uint8_t cyclesSinceLastProbe[NUMBER_OF_UARTS];
 	BaseType_t result = pdTRUE;
 
 	/* Fill Queue with requests for TestPaketPairs for every UART */
 	for( int i = 0 ; i < NUMBER_OF_UARTS ; i++)
 	{
-		if(config.UseProbingPacksWlConn[i] == true)
+		bool measuredPassively = config.UsePassiveMetricsWlConn[i] == true && passiveSampleReceived[i] &&
+		                         (xTaskGetTickCount() - tickTimeLastPassiveSample[i]) < pdMS_TO_TICKS(PASSIVE_METRICS_MAX_AGE);
+		bool sendProbe = false;
+
+		if(config.UseProbingPacksWlConn[i] != true)
+		{
+			continue;
+		}
+		if(cyclesSinceLastProbe[i] < PASSIVE_METRICS_PROBE_INTERVAL_CYCLES)
+		{
+			cyclesSinceLastProbe[i]++;
+		}
+
+		if(!measuredPassively)
+		{
+			sendProbe = probeIsDue(i);
+		}
+		else if(cyclesSinceLastProbe[i] >= PASSIVE_METRICS_PROBE_INTERVAL_CYCLES)
 		{
-			BaseType_t tempResult = xQueueSendToBack(queueRequestNewTestPacketPair, &request, ( TickType_t ) pdMS_TO_TICKS(NETWORK_METRICS_QUEUE_DELAY));
+			sendProbe = true; /* refresh the bandwidth, the data traffic can not show if it got lower */
+		}
+		else if(probeIsDue(i))
+		{
+			/* The link is measured on its data traffic, this probe is not needed */
+			numberOfProbeBytesSaved[i] += PROBE_PACK_AIRTIME_BYTES * config.ProbeTrainLengthWlConn[i];
+		}
+
+		if(sendProbe)
+		{
+			BaseType_t tempResult = xQueueSendToBack(queueRequestNewTestPacketPair[i], &request, ( TickType_t ) pdMS_TO_TICKS(NETWORK_METRICS_QUEUE_DELAY));
 			if (tempResult != pdTRUE)
 			{
 			result = tempResult;
 			}
+			else
+			{
+				probePending[i] = true;
+				tickTimeLastProbeRequest[i] = xTaskGetTickCount();
+				cyclesSinceLastProbe[i] = 0;
+			}
 		}
 	}
 	return result;
 }
 
+/*!
+* \fn static bool probeIsDue(uint8_t wirelessLink)
+* \brief Adaptive probe scheduler, called once per metrics task interval.
+*  While Q stays within PROBE_Q_STABLE_BAND_PERCENT, the probe interval doubles up to PROBE_INTERVAL_MAX_CYCLES.
+*  After a loss or if the link changed its routing state (Q threshold crossed), the link is probed immediately and the interval starts over.
+*  The probes of a link never use more than PROBE_AIRTIME_BUDGET_PERCENT of its baud rate (token bucket).
+* \return true if a test packet pair should be sent on this link now
+*/
+static bool probeIsDue(uint8_t wirelessLink)
+{
+	static uint8_t probeIntervalCycles[NUMBER_OF_UARTS] = {1,1,1,1};
+	static uint8_t cyclesSinceLastProbe[NUMBER_OF_UARTS];
+	static uint16_t QatLastProbe[NUMBER_OF_UARTS];
+	static tRoutingState linkStateAtLastProbe[NUMBER_OF_UARTS] = {ROUTING_STATE_PANIC, ROUTING_STATE_PANIC, ROUTING_STATE_PANIC, ROUTING_STATE_PANIC};
+	static uint16_t PLRlastCycle[NUMBER_OF_UARTS];
+	uint32_t probeAirtime = PROBE_PACK_AIRTIME_BYTES * config.ProbeTrainLengthWlConn[wirelessLink] * 1000; /* [mByte] */
+	uint32_t budgetPerCycle = (config.BaudRatesWirelessConn[wirelessLink] / NOF_BITS_PER_UART_BYTE) * PROBE_AIRTIME_BUDGET_PERCENT * config.NetworkMetricsTaskInterval / 100; /* [mByte] */
+	bool lossEvent = (PLR[wirelessLink] > PLRlastCycle[wirelessLink]);
+	bool thresholdCrossed = (linkState[wirelessLink] != linkStateAtLastProbe[wirelessLink]);
+	uint16_t QchangeAllowed = (uint16_t)(((uint32_t)QatLastProbe[wirelessLink] * PROBE_Q_STABLE_BAND_PERCENT) / 100);
+	bool Qstable = (Q[wirelessLink] >= QatLastProbe[wirelessLink] - QchangeAllowed) && (Q[wirelessLink] <= QatLastProbe[wirelessLink] + QchangeAllowed);
+
+	PLRlastCycle[wirelessLink] = PLR[wirelessLink];
+	probeBudgetMilliBytes[wirelessLink] += budgetPerCycle;
+	if(probeBudgetMilliBytes[wirelessLink] > 2 * probeAirtime)
+	{
+		probeBudgetMilliBytes[wirelessLink] = 2 * probeAirtime;
+	}
+	if(cyclesSinceLastProbe[wirelessLink] < PROBE_INTERVAL_MAX_CYCLES)
+	{
+		cyclesSinceLastProbe[wirelessLink]++;
+	}
+
+	if(!lossEvent && !thresholdCrossed && cyclesSinceLastProbe[wirelessLink] < probeIntervalCycles[wirelessLink])
+	{
+		return false;
+	}
+	if(probeBudgetMilliBytes[wirelessLink] < probeAirtime)
+	{
+		return false; /* airtime budget used up */
+	}
+
+	probeBudgetMilliBytes[wirelessLink] -= probeAirtime;
+	cyclesSinceLastProbe[wirelessLink] = 0;
+	if(lossEvent || thresholdCrossed || !Qstable)
+	{
+		probeIntervalCycles[wirelessLink] = 1;
+	}
+	else if(probeIntervalCycles[wirelessLink] < PROBE_INTERVAL_MAX_CYCLES)
+	{
+		probeIntervalCycles[wirelessLink] *= 2;
+	}
+	QatLastProbe[wirelessLink] = Q[wirelessLink];
+	linkStateAtLastProbe[wirelessLink] = linkState[wirelessLink];
+	return true;
+}
+
 /*!
 * \fn void copyTestPackagePayload(tWirelessPackage* testPackage, tTestPackagePayload* payload)
 * \brief Extracts the payload out of an testpacket
@@ -1203,66 +2000,51 @@ uint16_t getTimespan(uint16_t timestamp)
 	}
 }
 
-
-/*!
-* \fn uint8_t getNofSendTries(uint8_t payloadNr)
-* \brief maintains the payloadNrBuffer array and
-* returns the number of entries with value "payloadNr" in the payloadNrBuffer array
-*/
-uint8_t getNofSendTries(uint8_t payloadNr)
-{
-	static uint16_t payloadNrBufferIndex = 0;
-	uint8_t nofEntriesInBuffer = 0;
-
-	//payloadNrBuffer is implemented as ringbuffer:
-	payloadNrBuffer[payloadNrBufferIndex] = payloadNr;
-	payloadNrBufferIndex++;
-	payloadNrBufferIndex %= PACKAGE_BUFFER_SIZE;
-
-	for(int i = 0; i < PACKAGE_BUFFER_SIZE ; i++)
-	{
-		if(payloadNrBuffer[i] == payloadNr)
-		{
-			nofEntriesInBuffer ++;
-		}
-	}
-
-	return nofEntriesInBuffer;
-}
-
 /*!
 * \fn void initnetworkMetricsQueues(void)
 * \brief This function initializes the array of queues
 */
 static void initnetworkMetricsQueues(void)
 {
-	static uint8_t xStaticQueueToAssemble[ QUEUE_NOF_TEST_PACKET_REQUESTS * sizeof(bool) ]; /* The variable used to hold the queue's data structure. */
+	static uint8_t xStaticQueueToAssemble[NUMBER_OF_UARTS][ QUEUE_NOF_TEST_PACKET_REQUESTS * sizeof(bool) ]; /* The variable used to hold the queue's data structure. */
 	static uint8_t xStaticQueueToDisassemble[ QUEUE_NOF_TEST_PACKET_RESULTS * sizeof(tWirelessPackage) ]; /* The variable used to hold the queue's data structure. */
-	static StaticQueue_t ucQueueStorageToAssemble; /* The array to use as the queue's storage area. */
+	static uint8_t xStaticQueuePassiveSamples[ QUEUE_NOF_PASSIVE_METRIC_SAMPLES * sizeof(tPassiveMetricSample) ]; /* The variable used to hold the queue's data structure. */
+	static StaticQueue_t ucQueueStorageToAssemble[NUMBER_OF_UARTS]; /* The array to use as the queue's storage area. */
 	static StaticQueue_t ucQueueStorageToDisassemble; /* The array to use as the queue's storage area. */
+	static StaticQueue_t ucQueueStoragePassiveSamples; /* The array to use as the queue's storage area. */
 
-	queueRequestNewTestPacketPair = xQueueCreateStatic( QUEUE_NOF_TEST_PACKET_REQUESTS, sizeof(bool), xStaticQueueToAssemble, &ucQueueStorageToAssemble);
+	for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+	{
+		queueRequestNewTestPacketPair[i] = xQueueCreateStatic( QUEUE_NOF_TEST_PACKET_REQUESTS, sizeof(bool), xStaticQueueToAssemble[i], &ucQueueStorageToAssemble[i]);
+		if(queueRequestNewTestPacketPair[i] == NULL)
+		{
+			while(true){} /* malloc for queue failed */
+		}
+		vQueueAddToRegistry(queueRequestNewTestPacketPair[i], queueNameRequestNewTestPacketPair[i]);
+	}
 	queueTestPacketResults = xQueueCreateStatic( QUEUE_NOF_TEST_PACKET_RESULTS, sizeof(tWirelessPackage), xStaticQueueToDisassemble, &ucQueueStorageToDisassemble);
+	queuePassiveMetricSamples = xQueueCreateStatic( QUEUE_NOF_PASSIVE_METRIC_SAMPLES, sizeof(tPassiveMetricSample), xStaticQueuePassiveSamples, &ucQueueStoragePassiveSamples);
 
-	if( (queueRequestNewTestPacketPair == NULL) || (queueTestPacketResults == NULL) )
+	if( (queueTestPacketResults == NULL) || (queuePassiveMetricSamples == NULL) )
 	{
 		while(true){} /* malloc for queue failed */
 	}
-	vQueueAddToRegistry(queueRequestNewTestPacketPair, queueNameRequestNewTestPacketPair);
 	vQueueAddToRegistry(queueTestPacketResults, queueNameTestPacketResults);
+	vQueueAddToRegistry(queuePassiveMetricSamples, queueNamePassiveMetricSamples);
 }
 
 /*!
-* \fn ByseType_t popFromRequestNewTestPacketPairQueue(bool* request)
+* \fn ByseType_t popFromRequestNewTestPacketPairQueue(uint8_t wirelessLink, bool* request)
 * \brief Pops a package from queue
+* \param wirelessLink: link which should be probed
 * \param request: Pointer to result
 * \return Status if xQueueReceive has been successful
 */
-BaseType_t popFromRequestNewTestPacketPairQueue(bool* request)
+BaseType_t popFromRequestNewTestPacketPairQueue(uint8_t wirelessLink, bool* request)
 {
-	if(config.RoutingMethode == ROUTING_METHODE_METRICS)
+	if(config.RoutingMethode == ROUTING_METHODE_METRICS && wirelessLink < NUMBER_OF_UARTS)
 	{
-		return xQueueReceive(queueRequestNewTestPacketPair, request, ( TickType_t ) pdMS_TO_TICKS(NETWORK_METRICS_QUEUE_DELAY) );
+		return xQueueReceive(queueRequestNewTestPacketPair[wirelessLink], request, ( TickType_t ) pdMS_TO_TICKS(NETWORK_METRICS_QUEUE_DELAY) );
 	}
 	else
 	{
@@ -1287,3 +2069,219 @@ BaseType_t pushToTestPacketResultsQueue(tWirelessPackage* results)
 		return pdFAIL;
 	}
 }
+
+/*!
+* \fn void networkMetrics_passiveDataPackageSent(uint8_t wirelessLink, tWirelessPackage* pPackage)
+* \brief Reports a data package which is sent on a single link, its acknowledge is used to measure the link passively.
+*  Packages sent on several links are not reported: their acknowledge does not tell which copy arrived.
+*/
+void networkMetrics_passiveDataPackageSent(uint8_t wirelessLink, tWirelessPackage* pPackage)
+{
+	tPassiveMetricSample sample;
+
+	if(config.RoutingMethode != ROUTING_METHODE_METRICS || wirelessLink >= NUMBER_OF_UARTS || !config.UsePassiveMetricsWlConn[wirelessLink])
+	{
+		return;
+	}
+	sample.type = PASSIVE_SAMPLE_DATA_SENT;
+	sample.wirelessLink = wirelessLink;
+	sample.devNum = pPackage->devNum;
+	sample.payloadNr = pPackage->payloadNr;
+	sample.payloadNrLastInOrder = 0;
+	sample.bytes = TOTAL_WL_PACKAGE_SIZE + pPackage->payloadSize;
+	sample.tickTime = xTaskGetTickCount();
+	xQueueSendToBack(queuePassiveMetricSamples, &sample, ( TickType_t ) pdMS_TO_TICKS(NETWORK_METRICS_QUEUE_DELAY));
+}
+
+/*!
+* \fn void networkMetrics_passiveAckReceived(uint8_t wirelessLink, uint8_t devNum, uint16_t payloadNr, uint16_t payloadNrLastInOrder)
+* \brief Reports a received acknowledge to the passive metrics
+*/
+void networkMetrics_passiveAckReceived(uint8_t wirelessLink, uint8_t devNum, uint16_t payloadNr, uint16_t payloadNrLastInOrder)
+{
+	tPassiveMetricSample sample;
+
+	if(config.RoutingMethode != ROUTING_METHODE_METRICS || wirelessLink >= NUMBER_OF_UARTS)
+	{
+		return;
+	}
+	sample.type = PASSIVE_SAMPLE_ACK_RECEIVED;
+	sample.wirelessLink = wirelessLink;
+	sample.devNum = devNum;
+	sample.payloadNr = payloadNr;
+	sample.payloadNrLastInOrder = payloadNrLastInOrder;
+	sample.bytes = 0;
+	sample.tickTime = xTaskGetTickCount();
+	xQueueSendToBack(queuePassiveMetricSamples, &sample, ( TickType_t ) pdMS_TO_TICKS(NETWORK_METRICS_QUEUE_DELAY));
+}
+
+/*!
+* \fn static void processPassiveMetricSamples(void)
+* \brief Matches the sent data packages with the received acknowledges. Packages which are not acknowledged within
+*  TIMEOUT_TEST_PACKET_RETURN count as lost, like the test packets.
+*/
+static void processPassiveMetricSamples(void)
+{
+	tPassiveMetricSample sample;
+	TickType_t now;
+
+	while(xQueueReceive(queuePassiveMetricSamples, &sample, 0) == pdTRUE)
+	{
+		if(sample.type == PASSIVE_SAMPLE_DATA_SENT)
+		{
+			passiveSampleDataSent(&sample);
+		}
+		else
+		{
+			passiveSampleAckReceived(&sample);
+		}
+	}
+
+	now = xTaskGetTickCount();
+	for(int wirelessLink = 0 ; wirelessLink < NUMBER_OF_UARTS ; wirelessLink++)
+	{
+		for(int i = 0 ; i < PASSIVE_METRICS_NOF_OUTSTANDING_PACKS ; i++)
+		{
+			tOutstandingPassivePack* pack = &outstandingPassivePacks[wirelessLink][i];
+			if(pack->inUse && (now - pack->sendTickTime) >= pdMS_TO_TICKS(TIMEOUT_TEST_PACKET_RETURN))
+			{
+				pack->inUse = false;
+				updatePacketLossRatioPacketNOK(wirelessLink);
+				tickTimeLastPassiveSample[wirelessLink] = now;
+				passiveSampleReceived[wirelessLink] = true;
+			}
+		}
+	}
+}
+
+/*!
+* \fn static void passiveSampleDataSent(tPassiveMetricSample* sample)
+* \brief Stores the sent data package until its acknowledge arrives. A resend means that the previous send attempt
+*  was not acknowledged in time, so it counts as lost on the link it was sent on.
+*/
+static void passiveSampleDataSent(tPassiveMetricSample* sample)
+{
+	bool retransmitted = false;
+	int freeIndex = -1;
+
+	if(sample->wirelessLink >= NUMBER_OF_UARTS)
+	{
+		return;
+	}
+	for(int wirelessLink = 0 ; wirelessLink < NUMBER_OF_UARTS ; wirelessLink++)
+	{
+		for(int i = 0 ; i < PASSIVE_METRICS_NOF_OUTSTANDING_PACKS ; i++)
+		{
+			tOutstandingPassivePack* pack = &outstandingPassivePacks[wirelessLink][i];
+			if(pack->inUse && pack->devNum == sample->devNum && pack->payloadNr == sample->payloadNr)
+			{
+				pack->inUse = false;
+				updatePacketLossRatioPacketNOK(wirelessLink);
+				tickTimeLastPassiveSample[wirelessLink] = sample->tickTime;
+				passiveSampleReceived[wirelessLink] = true;
+				retransmitted = true;
+			}
+		}
+	}
+	for(int i = 0 ; i < PASSIVE_METRICS_NOF_OUTSTANDING_PACKS ; i++)
+	{
+		if(!outstandingPassivePacks[sample->wirelessLink][i].inUse)
+		{
+			freeIndex = i;
+			break;
+		}
+	}
+	if(freeIndex < 0)
+	{
+		return; /* too many packages in flight on this link, this one is not measured */
+	}
+	outstandingPassivePacks[sample->wirelessLink][freeIndex].payloadNr = sample->payloadNr;
+	outstandingPassivePacks[sample->wirelessLink][freeIndex].devNum = sample->devNum;
+	outstandingPassivePacks[sample->wirelessLink][freeIndex].bytes = sample->bytes;
+	outstandingPassivePacks[sample->wirelessLink][freeIndex].sendTickTime = sample->tickTime;
+	outstandingPassivePacks[sample->wirelessLink][freeIndex].retransmitted = retransmitted;
+	outstandingPassivePacks[sample->wirelessLink][freeIndex].inUse = true;
+}
+
+/*!
+* \fn static void passiveSampleAckReceived(tPassiveMetricSample* sample)
+* \brief The acknowledged package gives an RTT sample, the packages up to payloadNrLastInOrder of the same device
+*  are received as well (their own acknowledge might be lost).
+*/
+static void passiveSampleAckReceived(tPassiveMetricSample* sample)
+{
+	for(int wirelessLink = 0 ; wirelessLink < NUMBER_OF_UARTS ; wirelessLink++)
+	{
+		for(int i = 0 ; i < PASSIVE_METRICS_NOF_OUTSTANDING_PACKS ; i++)
+		{
+			tOutstandingPassivePack* pack = &outstandingPassivePacks[wirelessLink][i];
+			if(!pack->inUse || pack->devNum != sample->devNum)
+			{
+				continue;
+			}
+			if(pack->payloadNr == sample->payloadNr)
+			{
+				/* the acknowledge goes back through the modem the package was received on */
+				passivePackAcknowledged(wirelessLink, pack, sample->tickTime, (wirelessLink == sample->wirelessLink));
+			}
+			else if(!packageBuffer_isNewerPayloadNr(pack->payloadNr, sample->payloadNrLastInOrder))
+			{
+				passivePackAcknowledged(wirelessLink, pack, sample->tickTime, false);
+			}
+		}
+	}
+}
+
+/*!
+* \fn static void passivePackAcknowledged(uint8_t wirelessLink, tOutstandingPassivePack* pack, TickType_t ackTickTime, bool rttSampleValid)
+* \brief Counts the package as received on the link and adds its bytes (and RTT) to the samples of this metrics interval
+*/
+static void passivePackAcknowledged(uint8_t wirelessLink, tOutstandingPassivePack* pack, TickType_t ackTickTime, bool rttSampleValid)
+{
+	pack->inUse = false;
+	updatePacketLossRatioPacketOK(wirelessLink);
+	passiveAckedBytes[wirelessLink] += pack->bytes;
+	if(rttSampleValid && !pack->retransmitted)
+	{
+		passiveRTTsum[wirelessLink] += (ackTickTime - pack->sendTickTime) * portTICK_PERIOD_MS;
+		passiveNofRTTsamples[wirelessLink]++;
+	}
+	tickTimeLastPassiveSample[wirelessLink] = ackTickTime;
+	passiveSampleReceived[wirelessLink] = true;
+}
+
+/*!
+* \fn static bool linkHasPassiveMetrics(uint8_t wirelessLink)
+* \brief true if data packages were acknowledged on this link since the last metrics calculation
+*/
+static bool linkHasPassiveMetrics(uint8_t wirelessLink)
+{
+	return (passiveNofRTTsamples[wirelessLink] > 0 || passiveAckedBytes[wirelessLink] > 0);
+}
+
+/*!
+* \fn static void calculatePassiveMetrics(uint8_t wirelessLink)
+* \brief Updates RTT and SBPP from the data traffic of the last metrics interval.
+*  The acknowledged bytes per second are a lower bound of the bandwidth (the link does not need to be saturated),
+*  so above them, the bandwidth estimation only sinks slowly by PASSIVE_METRICS_SBPP_DECAY_PERCENT until the
+*  next probe of the link measures it again.
+*/
+static void calculatePassiveMetrics(uint8_t wirelessLink)
+{
+	uint32_t ackedBytesPerSecond = (passiveAckedBytes[wirelessLink] * 1000) / config.NetworkMetricsTaskInterval;
+	uint32_t decayedBandwidth;
+
+	if(passiveNofRTTsamples[wirelessLink] > 0)
+	{
+		RTTraw[wirelessLink] = passiveRTTsum[wirelessLink] / passiveNofRTTsamples[wirelessLink];
+		exponentialFilter(&RTTfilteredFixed[wirelessLink],&RTTfiltered[wirelessLink],&RTTraw[wirelessLink],rttFilterParam);
+	}
+	if(ackedBytesPerSecond > 0xFFFF)
+	{
+		ackedBytesPerSecond = 0xFFFF;
+	}
+	decayedBandwidth = ((uint32_t)SBPPfiltered[wirelessLink] * (100 - PASSIVE_METRICS_SBPP_DECAY_PERCENT)) / 100;
+	SBPPraw[wirelessLink] = (ackedBytesPerSecond > decayedBandwidth) ? ackedBytesPerSecond : decayedBandwidth;
+	exponentialFilter(&SBPPfilteredFixed[wirelessLink],&SBPPfiltered[wirelessLink],&SBPPraw[wirelessLink],sbppFilterParam);
+	CPP[wirelessLink] = config.CostPerPacketMetric[wirelessLink];
+}
@@ -67,7 +67,7 @@ bool packageBuffer_freeOlderThanCurrentPackage(tPackageBuffer* buffer)
 {
 	for(int i = 0 ; i < PACKAGE_BUFFER_SIZE ; i ++)
 	{
-		if(!buffer->indexIsEmpty[i] && (buffer->packageArray[i].payloadNr < buffer->payloadNrLastInOrder))
+		if(!buffer->indexIsEmpty[i] && !packageBuffer_isNewerOrEqualPayloadNr(buffer->packageArray[i].payloadNr, buffer->payloadNrLastInOrder))
 		{
 			vPortFree(buffer->packageArray[i].payload);
 			buffer->packageArray[i].payload = NULL;
@@ -119,7 +119,7 @@ bool packageBuffer_putIfNotOld(tPackageBuffer* buffer, tWirelessPackage* packet)
 	if(buffer->freeSpace > 0)
 	{
 		uint16_t indexOfFreePackage;
-		if((checkIfPackageInBuffer(buffer,packet->payloadNr)) || (packet->payloadNr <= buffer->payloadNrLastInOrder))
+		if((checkIfPackageInBuffer(buffer,packet->payloadNr)) || !packageBuffer_isNewerPayloadNr(packet->payloadNr, buffer->payloadNrLastInOrder))
 				return true;
 		if(getIndexOfFreeSpaceInBuffer(buffer, &indexOfFreePackage))
 		{
@@ -448,7 +448,7 @@ bool packageBuffer_getArrayOfPackagePayloadNrInBuffer(tPackageBuffer* buffer,siz
 */
 void packageBuffer_setCurrentPayloadNR(tPackageBuffer* buffer,uint16_t payloadNr)
 {
-	if(buffer->payloadNrLastInOrder < payloadNr)
+	if(packageBuffer_isNewerPayloadNr(payloadNr, buffer->payloadNrLastInOrder))
 		buffer->payloadNrLastInOrder = payloadNr;
 }
 
@@ -462,6 +462,27 @@ uint16_t packageBuffer_getCurrentPayloadNR(tPackageBuffer* buffer)
 }
 
 
+/*!
+* \fn bool packageBuffer_isNewerPayloadNr(uint16_t payloadNr, uint16_t referencePayloadNr)
+* \brief Compares two payloadNrs wrap safe (RFC 1982)
+* \return true if payloadNr was generated after referencePayloadNr
+*/
+bool packageBuffer_isNewerPayloadNr(uint16_t payloadNr, uint16_t referencePayloadNr)
+{
+	uint16_t distance = (uint16_t)(payloadNr - referencePayloadNr);
+	return (distance != 0) && (distance < PAYLOAD_NR_HALF_RANGE);
+}
+
+/*!
+* \fn bool packageBuffer_isNewerOrEqualPayloadNr(uint16_t payloadNr, uint16_t referencePayloadNr)
+* \brief Compares two payloadNrs wrap safe (RFC 1982)
+* \return true if payloadNr is equal to referencePayloadNr or was generated after it
+*/
+bool packageBuffer_isNewerOrEqualPayloadNr(uint16_t payloadNr, uint16_t referencePayloadNr)
+{
+	return (payloadNr == referencePayloadNr) || packageBuffer_isNewerPayloadNr(payloadNr, referencePayloadNr);
+}
+
 /*!
 * \fn static bool getIndexOfFreeSpaceInBuffer(tPackageBuffer* buffer, uint16* index)
 * \brief  returns a free index in the packageBuffer
@@ -491,7 +512,7 @@ static bool getIndexOfNextOrderedPackage(tPackageBuffer* buffer, uint16* index)
 {
 	for(int i = 0 ; i < PACKAGE_BUFFER_SIZE ; i ++)
 	{
-		if((!buffer->indexIsEmpty[i]) && (buffer->packageArray[i].payloadNr == (buffer->payloadNrLastInOrder)+1))
+		if((!buffer->indexIsEmpty[i]) && (buffer->packageArray[i].payloadNr == (uint16_t)(buffer->payloadNrLastInOrder+1)))
 		{
 			*index = i;
 			return true;
@@ -510,20 +531,19 @@ static bool getIndexOfOldestPackage(tPackageBuffer* buffer, uint16* index)
 {
 	if(buffer->count > 0)
 	{
+		bool foundPackage = false;
 		uint16_t oldestPayloadNR = 0;
 		for(int i = 0 ; i < PACKAGE_BUFFER_SIZE ; i ++)
 		{
-			if((oldestPayloadNR == 0) ||
-			   (buffer->packageArray[i].payloadNr < oldestPayloadNR))
+			if(!buffer->indexIsEmpty[i] &&
+			   (!foundPackage || packageBuffer_isNewerPayloadNr(oldestPayloadNR, buffer->packageArray[i].payloadNr)))
 			{
+				foundPackage = true;
 				oldestPayloadNR = buffer->packageArray[i].payloadNr;
 				*index = i;
 			}
 		}
-		if(oldestPayloadNR>0)
-		{
-			return true;
-		}
+		return foundPackage;
 	}
 	return false;
 }
@@ -23,6 +23,8 @@ static const char* queueNameAssembledPacks[] = {"AssembledPackages0", "Assembled
 uint8_t numOfInvalidRecWirelessPack[NUMBER_OF_UARTS];
 //static uint32_t sentAckNumTracker[NUMBER_OF_UARTS];
 static uint8_t sessionNr;
+static TaskHandle_t packageHandlerTaskHandle = NULL; /* to wake up the task when there is work in its queues */
+static uint32_t nofBytesInPacksToDisassembleQueue[NUMBER_OF_UARTS]; /* routed bytes not handed to the SPI byte queue yet (atomic access) */
 
 
 /* prototypes */
@@ -56,63 +58,96 @@ typedef enum eWiReceiveHandlerStates
 */
 void packageHandler_TaskEntry(void* p)
 {
-	static tWirelessPackage package;
 	const TickType_t taskInterval = pdMS_TO_TICKS(config.PackageHandlerTaskInterval);
 	TickType_t xLastWakeTime = xTaskGetTickCount(); /* Initialize the lastWakeTime variable with the current time. */
 
+	packageHandlerTaskHandle = xTaskGetCurrentTaskHandle();
+
 	for(;;)
 	{
-		vTaskDelayUntil( &xLastWakeTime, taskInterval ); /* Wait for the next cycle */
-		for(int wlConn = 0; wlConn < NUMBER_OF_UARTS; wlConn++)
+		if(config.EventDrivenTasks)
 		{
-			/* send packages byte wise to spi queue as long as there is enough space available for a full package */
-			while(nofPacksToDisassembleInQueue(wlConn) > 0)
+			ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(config.EventDrivenFallbackInterval)); /* Wait for work or the fallback tick */
+		}
+		else
+		{
+			vTaskDelayUntil( &xLastWakeTime, taskInterval ); /* Wait for the next cycle */
+		}
+		packageHandler_run();
+	}
+}
+
+/*!
+* \fn void packageHandler_run(void)
+* \brief One cycle of the package handler: sends packages byte wise to the wireless byte queues and
+* assembles packages from received wireless bytes.
+*/
+void packageHandler_run(void)
+{
+	static tWirelessPackage package;
+
+	for(int wlConn = 0; wlConn < NUMBER_OF_UARTS; wlConn++)
+	{
+		/* send packages byte wise to spi queue as long as there is enough space available for a full package */
+		while(nofPacksToDisassembleInQueue(wlConn) > 0)
+		{
+			/* check how much space is needed for next data package */
+			if(peekAtPackToDisassemble(wlConn, &package) != pdTRUE)
 			{
-				/* check how much space is needed for next data package */
-				if(peekAtPackToDisassemble(wlConn, &package) != pdTRUE)
-				{
-					break; /* leave inner while-loop if queue access unsuccessful and continue with next wlConn */
-				}
-				/* enough space for next package available? */
-				if(freeSpaceInTxByteQueue(MAX_14830_WIRELESS_SIDE, wlConn) > (TOTAL_WL_PACKAGE_SIZE + package.payloadSize))
+				break; /* leave inner while-loop if queue access unsuccessful and continue with next wlConn */
+			}
+			/* enough space for next package available? */
+			if(freeSpaceInTxByteQueue(MAX_14830_WIRELESS_SIDE, wlConn) > (TOTAL_WL_PACKAGE_SIZE + package.payloadSize))
+			{
+				if(popFromPacksToDisassembleQueue(wlConn, &package) == pdTRUE) /* there is a package ready for sending */
 				{
-					if(popFromPacksToDisassembleQueue(wlConn, &package) == pdTRUE) /* there is a package ready for sending */
+					if(sendPackageToWirelessQueue(wlConn, &package) != true) /* ToDo: handle resending of package */
 					{
-						if(sendPackageToWirelessQueue(wlConn, &package) != true) /* ToDo: handle resending of package */
-						{
-							/* entire package could not be pushed to queue byte wise, only fraction in queue now */
-							numberOfDroppedPackages[wlConn]++;
-							FRTOS_vPortFree(package.payload); /* free memory of package before returning from while loop */
-							package.payload = NULL;
-							break; /* exit while loop, no more packages are extracted for this uartNr */
-						}
-						else
-						{
-							FRTOS_vPortFree(package.payload); /* free memory of package once it is sent to device */
-							package.payload = NULL;
-						}
+						/* entire package could not be pushed to queue byte wise, only fraction in queue now */
+						numberOfDroppedPackages[wlConn]++;
+						FRTOS_vPortFree(package.payload); /* free memory of package before returning from while loop */
+						package.payload = NULL;
+						break; /* exit while loop, no more packages are extracted for this uartNr */
+					}
+					else
+					{
+						FRTOS_vPortFree(package.payload); /* free memory of package once it is sent to device */
+						package.payload = NULL;
+						spiHandler_notify();
 					}
-				}
-				else /* not enough space available for next package */
-				{
-					//char infoBuf[70];
-					//XF1_xsprintf(infoBuf, "Pushing pack to wireless %u not possible, too little space\r\n", wlConn);
-					//pushMsgToShellQueue(infoBuf);
-					break; /* leave inner while-loop */
 				}
 			}
-			/* assemble received bytes to form a full data package */
-			if(nofAssembledPacksInQueue(wlConn) < QUEUE_NUM_OF_WL_PACK_TO_ASSEMBLE) /* there is space available in Queue */
+			else /* not enough space available for next package */
 			{
-				if(numberOfBytesInRxByteQueue(MAX_14830_WIRELESS_SIDE, wlConn) > 0) /* there are characters waiting */
-				{
-					assembleWirelessPackages(wlConn);
-				}
+				//char infoBuf[70];
+				//XF1_xsprintf(infoBuf, "Pushing pack to wireless %u not possible, too little space\r\n", wlConn);
+				//pushMsgToShellQueue(infoBuf);
+				break; /* leave inner while-loop */
+			}
+		}
+		/* assemble received bytes to form a full data package */
+		if(nofAssembledPacksInQueue(wlConn) < QUEUE_NUM_OF_WL_PACK_TO_ASSEMBLE) /* there is space available in Queue */
+		{
+			if(numberOfBytesInRxByteQueue(MAX_14830_WIRELESS_SIDE, wlConn) > 0) /* there are characters waiting */
+			{
+				assembleWirelessPackages(wlConn);
 			}
 		}
 	}
 }
 
+/*!
+* \fn void packageHandler_notify(void)
+* \brief Wakes up the package handler task when EVENT_DRIVEN_TASKS is configured. Called by the tasks which put work into its queues.
+*/
+void packageHandler_notify(void)
+{
+	if(config.EventDrivenTasks && (packageHandlerTaskHandle != NULL))
+	{
+		xTaskNotifyGive(packageHandlerTaskHandle);
+	}
+}
+
 /*!
 * \fn void packageHandler_TaskInit(void)
 * \brief Initializes queues created by package handler and HW CRC generator
@@ -181,7 +216,7 @@ static bool sendPackageToWirelessQueue(tUartNr wlConn, tWirelessPackage* pPackag
 	pPackage->sessionNr = sessionNr;
 
 	//Embed the panicMode bool inside the devNum
-	if(pPackage->packType == PACK_TYPE_DATA_PACKAGE || pPackage->packType == PACK_TYPE_NETWORK_TEST_PACKAGE_FIRST ||pPackage->packType == PACK_TYPE_NETWORK_TEST_PACKAGE_SECOND )
+	if(pPackage->packType == PACK_TYPE_DATA_PACKAGE || pPackage->packType == PACK_TYPE_NETWORK_TEST_PACKAGE_FIRST ||pPackage->packType == PACK_TYPE_NETWORK_TEST_PACKAGE_SECOND || pPackage->packType == PACK_TYPE_PARITY_PACKAGE )
 	{
 		 if(pPackage->panicMode)
 		 {
@@ -432,7 +467,7 @@ static void assembleWirelessPackages(uint8_t wlConn)
 						pushMsgToShellQueue(infoBuf);
 					}
 					/* CRC is valid - also check if the header parameters are within the valid range */
-					if ((currentWirelessPackage[wlConn].packType > PACK_TYPE_NETWORK_TEST_PACKAGE_SECOND) ||
+					if ((currentWirelessPackage[wlConn].packType > PACK_TYPE_PARITY_PACKAGE) ||
 						(currentWirelessPackage[wlConn].packType == 0) ||
 						(currentWirelessPackage[wlConn].payloadSize > PACKAGE_MAX_PAYLOAD_SIZE))
 					{
@@ -535,7 +570,8 @@ static void assembleWirelessPackages(uint8_t wlConn)
 							}
 							else if ((currentWirelessPackage[wlConn].packType == PACK_TYPE_DATA_PACKAGE) ||
 									 (currentWirelessPackage[wlConn].packType == PACK_TYPE_NETWORK_TEST_PACKAGE_FIRST) ||
-									 (currentWirelessPackage[wlConn].packType == PACK_TYPE_NETWORK_TEST_PACKAGE_SECOND))
+									 (currentWirelessPackage[wlConn].packType == PACK_TYPE_NETWORK_TEST_PACKAGE_SECOND) ||
+									 (currentWirelessPackage[wlConn].packType == PACK_TYPE_PARITY_PACKAGE))
 							{
 								/* update throughput printout */
 								numberOfPacksReceived[wlConn]++;
@@ -749,6 +785,7 @@ static BaseType_t pushToAssembledPackagesQueue(tUartNr wlConn, tWirelessPackage*
 			{
 				pushPackageToLoggerQueue(pPackage, RECEIVED_PACKAGE, wlConn); /* content is only copied in this function, new package generated for logging queue inside this function */
 			}
+			networkHandler_notify();
 			return pdTRUE;
 		}
 	}
@@ -819,7 +856,12 @@ static BaseType_t popFromPacksToDisassembleQueue(tUartNr uartNr, tWirelessPackag
 {
 	if(uartNr < NUMBER_OF_UARTS)
 	{
-		return xQueueReceive(queuePackagesToDisassemble[uartNr], pPackage, ( TickType_t ) pdMS_TO_TICKS(MAX_DELAY_PACK_HANDLER_MS) );
+		if(xQueueReceive(queuePackagesToDisassemble[uartNr], pPackage, ( TickType_t ) pdMS_TO_TICKS(MAX_DELAY_PACK_HANDLER_MS) ) == pdTRUE)
+		{
+			__atomic_fetch_sub(&nofBytesInPacksToDisassembleQueue[uartNr], TOTAL_WL_PACKAGE_SIZE + pPackage->payloadSize, __ATOMIC_RELAXED);
+			return pdTRUE;
+		}
+		return pdFAIL;
 	}
 	return pdFAIL; /* if uartNr was not in range */
 }
@@ -872,6 +914,21 @@ uint16_t freeSpaceInPackagesToDisassembleQueue(tUartNr wlConn)
 	return 0; /* if wlConn was not in range */
 }
 
+/*!
+* \fn uint32_t numberOfBytesInPacksToDisassembleQueue(tUartNr wlConn)
+* \brief Returns the number of bytes of the packages which are routed to this link, but not in the TX byte queue yet
+* \param wlConn: WL conn where the packages will be transmitted to.
+* \return Bytes waiting in this queue
+*/
+uint32_t numberOfBytesInPacksToDisassembleQueue(tUartNr wlConn)
+{
+	if(wlConn < NUMBER_OF_UARTS)
+	{
+		return __atomic_load_n(&nofBytesInPacksToDisassembleQueue[wlConn], __ATOMIC_RELAXED);
+	}
+	return 0; /* if wlConn was not in range */
+}
+
 /*!
 * \fn ByseType_t pushToSentPackagesForDisassemblingQueue(tUartNr wlConn, tWirelessPackage package)
 * \brief Stores the sent package in correct queue.
@@ -881,15 +938,57 @@ uint16_t freeSpaceInPackagesToDisassembleQueue(tUartNr wlConn)
 */
 BaseType_t pushToPacksToDisassembleQueue(tUartNr wlConn, tWirelessPackage* pPackage)
 {
+	uint32_t bytes = TOTAL_WL_PACKAGE_SIZE + pPackage->payloadSize;
+
+	__atomic_fetch_add(&nofBytesInPacksToDisassembleQueue[wlConn], bytes, __ATOMIC_RELAXED); /* before the push, the package handler could pop it right away */
 	if(xQueueSendToBack(queuePackagesToDisassemble[wlConn], pPackage, ( TickType_t ) pdMS_TO_TICKS(MAX_DELAY_PACK_HANDLER_MS) ) == pdTRUE)
 	{
 		if(config.LoggingEnabled && pPackage->packType == PACK_TYPE_DATA_PACKAGE)
 		{
 			pushPackageToLoggerQueue(pPackage, SENT_PACKAGE, wlConn); /* content is only copied in this function, new package generated for logging queue inside this function */
 		}
+		packageHandler_notify();
 		return pdTRUE;
 	}
+	__atomic_fetch_sub(&nofBytesInPacksToDisassembleQueue[wlConn], bytes, __ATOMIC_RELAXED);
 	return pdFAIL;
 }
 
 
+
+/*!
+* \fn uint16_t packageHandler_getWirelessFrameSize(tWirelessPackage* pPackage)
+* \brief Number of bytes the package occupies on the wireless UART (before Golay encoding):
+*  PACK_START, header, payload and CRC including the PACK_REP replacements, plus the fill bytes at the end.
+*  The header fields and CRCs are taken as stored in the package (set when it was sent or received).
+* \param pPackage: the package
+* \return size of the frame in bytes
+*/
+uint16_t packageHandler_getWirelessFrameSize(tWirelessPackage* pPackage)
+{
+	/* same byte order as in sendPackageToWirelessQueue() */
+	uint8_t header[] = {
+			(uint8_t)pPackage->packType, pPackage->devNum, pPackage->sessionNr,
+			*((uint8_t*)(&pPackage->packNr) + 1), *((uint8_t*)(&pPackage->packNr) + 0),
+			*((uint8_t*)(&pPackage->payloadNr) + 1), *((uint8_t*)(&pPackage->payloadNr) + 0),
+			*((uint8_t*)(&pPackage->payloadSize) + 1), *((uint8_t*)(&pPackage->payloadSize) + 0),
+			pPackage->crc8Header,
+			*((uint8_t*)(&pPackage->crc16payload) + 1), *((uint8_t*)(&pPackage->crc16payload) + 0) };
+	uint16_t frameSize = 1 + sizeof(header) + pPackage->payloadSize + 2; /* PACK_START, header with CRCs, payload, 2 fill bytes */
+
+	for(int i = 0; i < sizeof(header); i++)
+	{
+		if(header[i] == PACK_START)
+		{
+			frameSize += 2; /* replaced by PACK_REP PACK_START PACK_REP */
+		}
+	}
+	for(uint16_t i = 0; (pPackage->payload != NULL) && (i < pPackage->payloadSize); i++)
+	{
+		if(pPackage->payload[i] == PACK_START)
+		{
+			frameSize += 2;
+		}
+	}
+	return frameSize;
+}
@@ -0,0 +1,544 @@
+/*
+ * ParityFec.c
+ * Forward error correction with systematic Reed-Solomon erasure coding over GF(256).
+ *
+ *  Created on: Oct 19, 2026
+ */
+#include "ParityFec.h"
+#include "FRTOS.h"
+
+/*! \def GF_POLYNOMIAL
+*  \brief Primitive polynomial x^8 + x^4 + x^3 + x^2 + 1 of the GF(256) arithmetic
+*/
+#define GF_POLYNOMIAL		0x11D
+
+/* --------------- prototypes ------------------- */
+static void initGaloisField(void);
+static uint8_t gfMul(uint8_t a, uint8_t b);
+static uint8_t gfInv(uint8_t a);
+static void gfMulAddRegion(uint8_t* dst, const uint8_t* src, uint8_t coefficient, uint16_t length);
+static void addSymbol(uint8_t* symbol, uint8_t coefficient, uint8_t* payload, uint16_t payloadSize);
+static void addDataToGroup(tFecDecoderGroup* group, uint8_t offset, uint8_t* payload, uint16_t payloadSize);
+static bool invertMatrix(uint8_t matrix[FEC_MAX_PARITY_PACKS][FEC_MAX_PARITY_PACKS], uint8_t inverse[FEC_MAX_PARITY_PACKS][FEC_MAX_PARITY_PACKS], uint8_t size);
+static tFecDecoderGroup* getDecoderGroup(tFecDecoder* decoder, uint16_t firstPayloadNr, bool createIfMissing);
+
+/* --------------- global variables -------------------- */
+static uint8_t gfExp[2*256];												/* gfExp[i] = 2^i, twice as long so that gfLog[a] + gfLog[b] needs no modulo */
+static uint8_t gfLog[256];
+static uint8_t coefficient[FEC_MAX_PARITY_PACKS][FEC_MAX_GROUP_SIZE];		/* coefficient of data package j in parity row i */
+static bool galoisFieldInitialized = false;
+
+/*!
+* \fn void parityFec_initEncoder(tFecEncoder* encoder)
+* \brief Initializes the encoder fields (and the GF(256) tables on the first call)
+*/
+void parityFec_initEncoder(tFecEncoder* encoder)
+{
+	initGaloisField();
+	encoder->nofPacks = 0;
+	encoder->nofParityPacksSent = 0;
+	encoder->groupSize = 0;
+	encoder->nofParityPacks = 0;
+	encoder->maxSymbolSize = 0;
+	encoder->firstPayloadNr = 0;
+	encoder->tickTimeLastPackAdded = 0;
+	for(int row = 0 ; row < FEC_MAX_PARITY_PACKS ; row++)
+	{
+		for(int i = 0 ; i < FEC_SYMBOL_SIZE ; i++)
+		{
+			encoder->parity[row][i] = 0;
+		}
+	}
+}
+
+/*!
+* \fn void parityFec_initDecoder(tFecDecoder* decoder)
+* \brief Initializes the decoder fields (and the GF(256) tables on the first call)
+*/
+void parityFec_initDecoder(tFecDecoder* decoder)
+{
+	initGaloisField();
+	for(int i = 0 ; i < FEC_NOF_DECODER_GROUPS ; i++)
+	{
+		decoder->group[i].inUse = false;
+	}
+}
+
+/*!
+* \fn void parityFec_addDataPackage(tFecEncoder* encoder, tWirelessPackage* pPackage, uint8_t groupSize, uint8_t nofParityPacks)
+* \brief Adds a newly generated data package to the current group and stores the first payloadNr of the group in its packNr.
+*  Needs to be called before the package is copied into the send buffer.
+* \param groupSize, nofParityPacks: size of the group and its number of parity packages, only used when a new group starts
+*/
+void parityFec_addDataPackage(tFecEncoder* encoder, tWirelessPackage* pPackage, uint8_t groupSize, uint8_t nofParityPacks)
+{
+	if(pPackage->payloadSize > FEC_MAX_DATA_PAYLOAD_SIZE)
+	{
+		pPackage->packNr = pPackage->payloadNr + FEC_MAX_GROUP_SIZE; /* can not be protected, the parity packages would get too big */
+		return;
+	}
+	/* parity generation of the last group was interrupted, or the group is full and its parity was never generated
+	 * (malloc failed): give it up */
+	if(encoder->nofParityPacksSent > 0 || (encoder->nofPacks > 0 && encoder->nofPacks >= encoder->groupSize))
+	{
+		parityFec_initEncoder(encoder);
+	}
+	if(encoder->nofPacks == 0)
+	{
+		encoder->firstPayloadNr = pPackage->payloadNr;
+		encoder->groupSize = (groupSize > FEC_MAX_GROUP_SIZE) ? FEC_MAX_GROUP_SIZE : groupSize;
+		encoder->nofParityPacks = (nofParityPacks > FEC_MAX_PARITY_PACKS) ? FEC_MAX_PARITY_PACKS : nofParityPacks;
+		if(encoder->groupSize == 0)
+		{
+			encoder->groupSize = 1;
+		}
+		if(encoder->nofParityPacks == 0)
+		{
+			encoder->nofParityPacks = 1;
+		}
+	}
+	for(int row = 0 ; row < encoder->nofParityPacks ; row++)
+	{
+		addSymbol(encoder->parity[row], coefficient[row][encoder->nofPacks], pPackage->payload, pPackage->payloadSize);
+	}
+	if(sizeof(uint16_t) + pPackage->payloadSize > encoder->maxSymbolSize)
+	{
+		encoder->maxSymbolSize = sizeof(uint16_t) + pPackage->payloadSize;
+	}
+	encoder->nofPacks++;
+	encoder->tickTimeLastPackAdded = xTaskGetTickCount();
+	pPackage->packNr = encoder->firstPayloadNr;
+}
+
+/*!
+* \fn bool parityFec_generateParityPackage(tFecEncoder* encoder, uint16_t timeoutTicks, tWirelessPackage* pPackage)
+* \brief Generates the next parity package of the current group if the group is complete or if no data package
+*  was added for timeoutTicks. After the last parity package of the group, the encoder starts a new group.
+*  The payload needs to be freed after usage!
+* \return true if a parity package was generated
+*/
+bool parityFec_generateParityPackage(tFecEncoder* encoder, uint16_t timeoutTicks, tWirelessPackage* pPackage)
+{
+	uint8_t row = encoder->nofParityPacksSent;
+
+	if(encoder->nofPacks == 0)
+	{
+		return false;
+	}
+	if(encoder->nofPacks < encoder->groupSize && (TickType_t)(xTaskGetTickCount() - encoder->tickTimeLastPackAdded) < timeoutTicks)
+	{
+		return false; /* wait for the rest of the group */
+	}
+
+	pPackage->payloadSize = FEC_PARITY_HEADER_SIZE + encoder->maxSymbolSize;
+	pPackage->payload = (uint8_t*) FRTOS_pvPortMalloc(pPackage->payloadSize*sizeof(int8_t));
+	if(pPackage->payload == NULL) /* malloc failed, try again in the next cycle */
+	{
+		return false;
+	}
+	pPackage->payload[0] = encoder->nofPacks;
+	pPackage->payload[1] = row;
+	for(int i = 0 ; i < encoder->maxSymbolSize ; i++)
+	{
+		pPackage->payload[FEC_PARITY_HEADER_SIZE + i] = encoder->parity[row][i];
+		encoder->parity[row][i] = 0;
+	}
+	pPackage->packType = PACK_TYPE_PARITY_PACKAGE;
+	pPackage->packNr = encoder->firstPayloadNr;
+	pPackage->payloadNr = encoder->firstPayloadNr + encoder->nofPacks - 1;
+
+	encoder->nofParityPacksSent++;
+	if(encoder->nofParityPacksSent >= encoder->nofParityPacks) /* start the next group */
+	{
+		encoder->nofPacks = 0;
+		encoder->nofParityPacksSent = 0;
+		encoder->maxSymbolSize = 0;
+	}
+	return true;
+}
+
+/*!
+* \fn void parityFec_receivedDataPackage(tFecDecoder* decoder, tWirelessPackage* pPackage)
+* \brief Adds the payload of a received data package to its group. Packages received twice are ignored.
+*/
+void parityFec_receivedDataPackage(tFecDecoder* decoder, tWirelessPackage* pPackage)
+{
+	uint16_t offset = (uint16_t)(pPackage->payloadNr - pPackage->packNr);
+	tFecDecoderGroup* group;
+
+	if(offset >= FEC_MAX_GROUP_SIZE || pPackage->payloadSize > FEC_MAX_DATA_PAYLOAD_SIZE)
+	{
+		return; /* package is not protected by parity packages */
+	}
+	group = getDecoderGroup(decoder, pPackage->packNr, true);
+	if(group == NULL || (group->receivedMask & (1u << offset)))
+	{
+		return; /* group too old or package received twice */
+	}
+	addDataToGroup(group, offset, pPackage->payload, pPackage->payloadSize);
+}
+
+/*!
+* \fn void parityFec_receivedParityPackage(tFecDecoder* decoder, tWirelessPackage* pPackage)
+* \brief Adds the payload of a received parity package to its group. Packages received twice are ignored.
+*/
+void parityFec_receivedParityPackage(tFecDecoder* decoder, tWirelessPackage* pPackage)
+{
+	tFecDecoderGroup* group;
+	uint8_t groupSize, row;
+	uint16_t symbolSize;
+
+	if(pPackage->payloadSize < FEC_PARITY_HEADER_SIZE)
+	{
+		return;
+	}
+	groupSize = pPackage->payload[0];
+	row = pPackage->payload[1];
+	symbolSize = pPackage->payloadSize - FEC_PARITY_HEADER_SIZE;
+	if(groupSize == 0 || groupSize > FEC_MAX_GROUP_SIZE || row >= FEC_MAX_PARITY_PACKS ||
+	   (uint16_t)(pPackage->payloadNr - pPackage->packNr) != groupSize - 1)
+	{
+		return; /* invalid parity header */
+	}
+	group = getDecoderGroup(decoder, pPackage->packNr, true);
+	if(group == NULL || (group->parityReceivedMask & (1u << row)))
+	{
+		return; /* group too old or package received twice */
+	}
+	gfMulAddRegion(group->syndrome[row], &pPackage->payload[FEC_PARITY_HEADER_SIZE], 1, symbolSize);
+	if(symbolSize > group->maxSymbolSize)
+	{
+		group->maxSymbolSize = symbolSize;
+	}
+	group->groupSize = groupSize;
+	group->parityReceivedMask |= (1u << row);
+	group->nofParityReceived++;
+}
+
+/*!
+* \fn bool parityFec_rebuildLostPackage(tFecDecoder* decoder, uint16_t firstPayloadNr, tWirelessPackage* pPackage)
+* \brief Rebuilds one lost data package of the group firstPayloadNr if at least as many parity packages as lost
+*  data packages were received. Call it again until it returns false to rebuild all lost packages.
+*  The payload needs to be freed after usage!
+* \return true if a package was rebuilt
+*/
+bool parityFec_rebuildLostPackage(tFecDecoder* decoder, uint16_t firstPayloadNr, tWirelessPackage* pPackage)
+{
+	static uint8_t symbol[FEC_SYMBOL_SIZE]; /* static because it is too big for the task stack */
+	tFecDecoderGroup* group = getDecoderGroup(decoder, firstPayloadNr, false);
+	uint8_t matrix[FEC_MAX_PARITY_PACKS][FEC_MAX_PARITY_PACKS];
+	uint8_t inverse[FEC_MAX_PARITY_PACKS][FEC_MAX_PARITY_PACKS];
+	uint8_t missingOffset[FEC_MAX_PARITY_PACKS];
+	uint8_t parityRow[FEC_MAX_PARITY_PACKS];
+	uint8_t nofMissing, n;
+	uint16_t payloadSize;
+
+	if(group == NULL || group->groupSize == 0 || group->nofReceived >= group->groupSize)
+	{
+		return false; /* parity not received yet or nothing lost */
+	}
+	nofMissing = group->groupSize - group->nofReceived;
+	if(nofMissing > group->nofParityReceived)
+	{
+		return false; /* too many packages lost (yet) */
+	}
+
+	/* the syndromes of the received parity rows only contain the lost packages:
+	 * syndrome[parityRow[k]] = sum over l of coefficient[parityRow[k]][missingOffset[l]] * lostSymbol[l] */
+	n = 0;
+	for(uint8_t offset = 0 ; offset < group->groupSize && n < nofMissing ; offset++)
+	{
+		if(!(group->receivedMask & (1u << offset)))
+		{
+			missingOffset[n++] = offset;
+		}
+	}
+	n = 0;
+	for(uint8_t row = 0 ; row < FEC_MAX_PARITY_PACKS && n < nofMissing ; row++)
+	{
+		if(group->parityReceivedMask & (1u << row))
+		{
+			parityRow[n++] = row;
+		}
+	}
+	for(int k = 0 ; k < nofMissing ; k++)
+	{
+		for(int l = 0 ; l < nofMissing ; l++)
+		{
+			matrix[k][l] = coefficient[parityRow[k]][missingOffset[l]];
+		}
+	}
+	if(!invertMatrix(matrix, inverse, nofMissing))
+	{
+		return false; /* can not happen with a Cauchy matrix */
+	}
+
+	/* first lost symbol = first row of the inverse times the syndromes */
+	for(int i = 0 ; i < group->maxSymbolSize ; i++)
+	{
+		symbol[i] = 0;
+	}
+	for(int k = 0 ; k < nofMissing ; k++)
+	{
+		gfMulAddRegion(symbol, group->syndrome[parityRow[k]], inverse[0][k], group->maxSymbolSize);
+	}
+	payloadSize = (uint16_t)((symbol[0] << 8) | symbol[1]);
+	if(payloadSize > FEC_MAX_DATA_PAYLOAD_SIZE || sizeof(uint16_t) + payloadSize > group->maxSymbolSize)
+	{
+		group->groupSize = 0; /* corrupt group, give it up */
+		return false;
+	}
+
+	pPackage->payloadSize = payloadSize;
+	pPackage->payload = (uint8_t*) FRTOS_pvPortMalloc(pPackage->payloadSize*sizeof(int8_t));
+	if(pPackage->payload == NULL) /* malloc failed, try again with the next package of this group */
+	{
+		return false;
+	}
+	for(int i = 0 ; i < pPackage->payloadSize ; i++)
+	{
+		pPackage->payload[i] = symbol[sizeof(uint16_t) + i];
+	}
+	pPackage->packType = PACK_TYPE_DATA_PACKAGE;
+	pPackage->packNr = firstPayloadNr;
+	pPackage->payloadNr = firstPayloadNr + missingOffset[0];
+
+	/* the rebuilt package counts as received, so the next call can rebuild the next lost package */
+	addDataToGroup(group, missingOffset[0], pPackage->payload, pPackage->payloadSize);
+	return true;
+}
+
+/*!
+* \fn static void initGaloisField(void)
+* \brief Fills the log and exp tables of GF(256) and the coefficients of the parity rows.
+*  The coefficients are the Cauchy matrix 1 / (x_i + y_j) with x_i = i and y_j = FEC_MAX_PARITY_PACKS + j,
+*  every column divided by its first row. Every square submatrix stays invertible, so any lost packages
+*  up to the number of received parity rows can be rebuilt, and the first row becomes the XOR parity.
+*/
+static void initGaloisField(void)
+{
+	uint16_t value = 1;
+
+	if(galoisFieldInitialized)
+	{
+		return;
+	}
+	for(int i = 0 ; i < 255 ; i++)
+	{
+		gfExp[i] = (uint8_t)value;
+		gfExp[i + 255] = (uint8_t)value;
+		gfLog[value] = i;
+		value <<= 1;
+		if(value & 0x100)
+		{
+			value ^= GF_POLYNOMIAL;
+		}
+	}
+	gfExp[510] = gfExp[0];
+	gfExp[511] = gfExp[1];
+	gfLog[0] = 0; /* not defined, zero is handled separately */
+
+	for(int j = 0 ; j < FEC_MAX_GROUP_SIZE ; j++)
+	{
+		uint8_t firstRow = gfInv(0 ^ (FEC_MAX_PARITY_PACKS + j));
+		for(int i = 0 ; i < FEC_MAX_PARITY_PACKS ; i++)
+		{
+			uint8_t cauchy = gfInv(i ^ (FEC_MAX_PARITY_PACKS + j));
+			coefficient[i][j] = gfMul(cauchy, gfInv(firstRow));
+		}
+	}
+	galoisFieldInitialized = true;
+}
+
+/*!
+* \fn static uint8_t gfMul(uint8_t a, uint8_t b)
+* \brief multiplication in GF(256)
+*/
+static uint8_t gfMul(uint8_t a, uint8_t b)
+{
+	if(a == 0 || b == 0)
+	{
+		return 0;
+	}
+	return gfExp[gfLog[a] + gfLog[b]];
+}
+
+/*!
+* \fn static uint8_t gfInv(uint8_t a)
+* \brief multiplicative inverse in GF(256), a must not be zero
+*/
+static uint8_t gfInv(uint8_t a)
+{
+	return gfExp[255 - gfLog[a]];
+}
+
+/*!
+* \fn static void gfMulAddRegion(uint8_t* dst, const uint8_t* src, uint8_t coefficient, uint16_t length)
+* \brief dst = dst + coefficient * src for length bytes (addition in GF(256) is XOR)
+*/
+static void gfMulAddRegion(uint8_t* dst, const uint8_t* src, uint8_t coefficient, uint16_t length)
+{
+	uint16_t logCoefficient;
+
+	if(coefficient == 0)
+	{
+		return;
+	}
+	if(coefficient == 1)
+	{
+		for(int i = 0 ; i < length ; i++)
+		{
+			dst[i] ^= src[i];
+		}
+		return;
+	}
+	logCoefficient = gfLog[coefficient];
+	for(int i = 0 ; i < length ; i++)
+	{
+		if(src[i] != 0)
+		{
+			dst[i] ^= gfExp[gfLog[src[i]] + logCoefficient];
+		}
+	}
+}
+
+/*!
+* \fn static void addSymbol(uint8_t* symbol, uint8_t coefficient, uint8_t* payload, uint16_t payloadSize)
+* \brief adds coefficient * { payloadSize, payload } to the symbol
+*/
+static void addSymbol(uint8_t* symbol, uint8_t coefficient, uint8_t* payload, uint16_t payloadSize)
+{
+	uint8_t sizeBytes[sizeof(uint16_t)] = { (uint8_t)(payloadSize >> 8), (uint8_t)payloadSize };
+
+	gfMulAddRegion(symbol, sizeBytes, coefficient, sizeof(uint16_t));
+	gfMulAddRegion(&symbol[sizeof(uint16_t)], payload, coefficient, payloadSize);
+}
+
+/*!
+* \fn static void addDataToGroup(tFecDecoderGroup* group, uint8_t offset, uint8_t* payload, uint16_t payloadSize)
+* \brief adds the coded data package to the syndromes of all parity rows and marks it as received
+*/
+static void addDataToGroup(tFecDecoderGroup* group, uint8_t offset, uint8_t* payload, uint16_t payloadSize)
+{
+	for(int row = 0 ; row < FEC_MAX_PARITY_PACKS ; row++)
+	{
+		addSymbol(group->syndrome[row], coefficient[row][offset], payload, payloadSize);
+	}
+	if(sizeof(uint16_t) + payloadSize > group->maxSymbolSize)
+	{
+		group->maxSymbolSize = sizeof(uint16_t) + payloadSize;
+	}
+	group->receivedMask |= (1u << offset);
+	group->nofReceived++;
+}
+
+/*!
+* \fn static bool invertMatrix(uint8_t matrix[FEC_MAX_PARITY_PACKS][FEC_MAX_PARITY_PACKS], uint8_t inverse[FEC_MAX_PARITY_PACKS][FEC_MAX_PARITY_PACKS], uint8_t size)
+* \brief inverts the size x size matrix in GF(256) with Gauss-Jordan elimination. matrix is overwritten.
+* \return false if the matrix is singular
+*/
+static bool invertMatrix(uint8_t matrix[FEC_MAX_PARITY_PACKS][FEC_MAX_PARITY_PACKS], uint8_t inverse[FEC_MAX_PARITY_PACKS][FEC_MAX_PARITY_PACKS], uint8_t size)
+{
+	for(int row = 0 ; row < size ; row++)
+	{
+		for(int col = 0 ; col < size ; col++)
+		{
+			inverse[row][col] = (row == col) ? 1 : 0;
+		}
+	}
+	for(int col = 0 ; col < size ; col++)
+	{
+		int pivot = col;
+		uint8_t pivotInverse;
+
+		while(pivot < size && matrix[pivot][col] == 0)
+		{
+			pivot++;
+		}
+		if(pivot == size)
+		{
+			return false;
+		}
+		for(int i = 0 ; i < size ; i++) /* swap pivot row up */
+		{
+			uint8_t tmp = matrix[col][i];
+			matrix[col][i] = matrix[pivot][i];
+			matrix[pivot][i] = tmp;
+			tmp = inverse[col][i];
+			inverse[col][i] = inverse[pivot][i];
+			inverse[pivot][i] = tmp;
+		}
+		pivotInverse = gfInv(matrix[col][col]);
+		for(int i = 0 ; i < size ; i++) /* normalize pivot row */
+		{
+			matrix[col][i] = gfMul(matrix[col][i], pivotInverse);
+			inverse[col][i] = gfMul(inverse[col][i], pivotInverse);
+		}
+		for(int row = 0 ; row < size ; row++) /* eliminate column in all other rows */
+		{
+			uint8_t factor = matrix[row][col];
+			if(row == col || factor == 0)
+			{
+				continue;
+			}
+			for(int i = 0 ; i < size ; i++)
+			{
+				matrix[row][i] ^= gfMul(factor, matrix[col][i]);
+				inverse[row][i] ^= gfMul(factor, inverse[col][i]);
+			}
+		}
+	}
+	return true;
+}
+
+/*!
+* \fn static tFecDecoderGroup* getDecoderGroup(tFecDecoder* decoder, uint16_t firstPayloadNr, bool createIfMissing)
+* \brief Returns the group which starts with firstPayloadNr. If there is none and createIfMissing is set, a free group
+*  or the group with the oldest firstPayloadNr is reused. Groups older than all collected groups are not created.
+* \return the group or NULL
+*/
+static tFecDecoderGroup* getDecoderGroup(tFecDecoder* decoder, uint16_t firstPayloadNr, bool createIfMissing)
+{
+	tFecDecoderGroup* groupToReuse = NULL;
+
+	for(int i = 0 ; i < FEC_NOF_DECODER_GROUPS ; i++)
+	{
+		tFecDecoderGroup* group = &decoder->group[i];
+		if(group->inUse && group->firstPayloadNr == firstPayloadNr)
+		{
+			return group;
+		}
+		if(!group->inUse)
+		{
+			groupToReuse = group;
+		}
+		else if(groupToReuse == NULL || (groupToReuse->inUse && packageBuffer_isNewerPayloadNr(groupToReuse->firstPayloadNr, group->firstPayloadNr)))
+		{
+			groupToReuse = group;
+		}
+	}
+	if(!createIfMissing || groupToReuse == NULL)
+	{
+		return NULL;
+	}
+	if(groupToReuse->inUse && packageBuffer_isNewerPayloadNr(groupToReuse->firstPayloadNr, firstPayloadNr))
+	{
+		return NULL; /* late package of a group which was already given up */
+	}
+	groupToReuse->inUse = true;
+	groupToReuse->firstPayloadNr = firstPayloadNr;
+	groupToReuse->receivedMask = 0;
+	groupToReuse->nofReceived = 0;
+	groupToReuse->groupSize = 0;
+	groupToReuse->parityReceivedMask = 0;
+	groupToReuse->nofParityReceived = 0;
+	groupToReuse->maxSymbolSize = 0;
+	for(int row = 0 ; row < FEC_MAX_PARITY_PACKS ; row++)
+	{
+		for(int i = 0 ; i < FEC_SYMBOL_SIZE ; i++)
+		{
+			groupToReuse->syndrome[row][i] = 0;
+		}
+	}
+	return groupToReuse;
+}
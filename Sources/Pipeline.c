@@ -0,0 +1,46 @@
+/*
+ * Pipeline.c
+ * Runs the SPI, package, network and transport handler as direct function calls within one task
+ * (RUN_TO_COMPLETION_PIPELINE).
+ *
+ *  Created on: Oct 19, 2026
+ */
+#include "Pipeline.h"
+#include "FRTOS.h"
+#include "Config.h"
+#include "SpiHandler.h"
+#include "PackageHandler.h"
+#include "NetworkHandler.h"
+#include "TransportHandler.h"
+
+/*!
+* \fn void pipeline_TaskEntry(void* p)
+* \brief Task initializes the MAX14830 and then runs the whole transmit and receive chain every SPI_HANDLER_TASK_INTERVAL:
+* SPI read -> package handler -> network handler -> transport handler -> network handler -> package handler -> SPI write
+*/
+void pipeline_TaskEntry(void* p)
+{
+	const TickType_t taskInterval = pdMS_TO_TICKS(config.SpiHandlerTaskInterval);
+	TickType_t xLastWakeTime;
+
+	spiHandler_initMax14830();
+	xLastWakeTime = xTaskGetTickCount(); /* Initialize the lastWakeTime variable with the current time. */
+
+	for(;;)
+	{
+		vTaskDelayUntil( &xLastWakeTime, taskInterval ); /* Wait for the next cycle */
+
+		/* receive chain: wireless bytes -> packages -> payloads on the device side */
+		spiHandler_readHwBufs();
+		packageHandler_run();
+		networkHandler_run();
+
+		/* the transport handler consumes the received packages and generates new ones from the device bytes */
+		transportHandler_run();
+
+		/* transmit chain: generated packages -> routing -> wireless bytes */
+		networkHandler_run();
+		packageHandler_run();
+		spiHandler_writeHwBufs();
+	}
+}
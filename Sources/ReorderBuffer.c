@@ -0,0 +1,205 @@
+/*
+ * ReorderBuffer.c
+ * Ring buffer for the payload reordering on the receive side.
+ *
+ *  Created on: Oct 19, 2026
+ */
+#include "ReorderBuffer.h"
+#include "FRTOS.h"
+
+/* --------------- prototypes ------------------- */
+static uint16_t getIndexOfPayloadNr(uint16_t payloadNr);
+static void freeIndex(tReorderBuffer* buffer, uint16_t index);
+
+/*!
+* \fn void reorderBuffer_init(tReorderBuffer* buffer)
+* \brief Initializes the buffer fields
+*/
+void reorderBuffer_init(tReorderBuffer* buffer)
+{
+	buffer->count = 0;
+	buffer->payloadNrLastInOrder = 0;
+	buffer->nofBytesSentOfNextPayload = 0;
+	for(int i = 0 ; i < REORDER_BUFFER_SIZE ; i ++)
+	{
+		buffer->indexIsEmpty[i] = true;
+		buffer->tickTimestampBufferInsertion[i] = 0;
+		buffer->packageArray[i].payload = NULL;
+	}
+}
+
+/*!
+* \fn void reorderBuffer_free(tReorderBuffer* buffer, uint16_t payloadNrLastInOrder)
+* \brief Frees all packages in the buffer (also their payloads) and restarts the ordering after payloadNrLastInOrder
+*/
+void reorderBuffer_free(tReorderBuffer* buffer, uint16_t payloadNrLastInOrder)
+{
+	for(int i = 0 ; i < REORDER_BUFFER_SIZE ; i ++)
+	{
+		if(!buffer->indexIsEmpty[i])
+		{
+			freeIndex(buffer, i);
+		}
+	}
+	buffer->payloadNrLastInOrder = payloadNrLastInOrder;
+	buffer->nofBytesSentOfNextPayload = 0;
+}
+
+/*!
+* \fn tReorderBufferPutResult reorderBuffer_put(tReorderBuffer* buffer, tWirelessPackage* packet)
+* \brief Copies the packet into the buffer if it is new.
+*  Packages which are already in the buffer or older than the last package in order are ignored.
+*  A package too far ahead of the last package in order restarts the ordering before it if the buffer is empty,
+*  otherwise it is dropped until the timeout has pushed out the stored packages.
+*/
+tReorderBufferPutResult reorderBuffer_put(tReorderBuffer* buffer, tWirelessPackage* packet)
+{
+	uint16_t distanceToLastInOrder = (uint16_t)(packet->payloadNr - buffer->payloadNrLastInOrder);
+	uint16_t index = getIndexOfPayloadNr(packet->payloadNr);
+
+	if(!packageBuffer_isNewerPayloadNr(packet->payloadNr, buffer->payloadNrLastInOrder)) /* already pushed out or skipped */
+	{
+		return REORDER_BUFFER_PUT_STORED;
+	}
+	if(distanceToLastInOrder > REORDER_BUFFER_SIZE) /* no space reserved for this package yet */
+	{
+		if(buffer->count > 0)
+		{
+			return REORDER_BUFFER_PUT_DROPPED; /* the timeout skips the gap, the resent package fits in afterwards */
+		}
+		buffer->payloadNrLastInOrder = packet->payloadNr - 1; /* the gap is lost, continue with this package */
+		buffer->nofBytesSentOfNextPayload = 0;
+	}
+	if(!buffer->indexIsEmpty[index]) /* redundant package */
+	{
+		return REORDER_BUFFER_PUT_STORED;
+	}
+
+	buffer->packageArray[index] = *packet;
+	buffer->packageArray[index].payload = FRTOS_pvPortMalloc(packet->payloadSize*sizeof(int8_t));
+	if(buffer->packageArray[index].payload == NULL)
+	{
+		return REORDER_BUFFER_PUT_NO_MEMORY;
+	}
+	for(int cnt = 0; cnt < packet->payloadSize; cnt++)
+	{
+		buffer->packageArray[index].payload[cnt] = packet->payload[cnt];
+	}
+	buffer->indexIsEmpty[index] = false;
+	buffer->tickTimestampBufferInsertion[index] = xTaskGetTickCount();
+	buffer->count ++;
+	return REORDER_BUFFER_PUT_STORED;
+}
+
+/*!
+* \fn bool reorderBuffer_getNextOrderedPayload(tReorderBuffer* buffer, uint8_t** payload, uint16_t* nofBytes)
+* \brief Returns the bytes of the next payload in order which were not pushed out yet. The package stays in the buffer
+*  until it is consumed with reorderBuffer_consumeOrderedPayload().
+* \param payload: Pointer to the first byte which was not pushed out yet
+* \param nofBytes: Number of bytes left in this payload
+* \return true if the next package in order is in the buffer
+*/
+bool reorderBuffer_getNextOrderedPayload(tReorderBuffer* buffer, uint8_t** payload, uint16_t* nofBytes)
+{
+	uint16_t index = getIndexOfPayloadNr(buffer->payloadNrLastInOrder + 1);
+
+	if(buffer->count == 0 || buffer->indexIsEmpty[index])
+	{
+		return false;
+	}
+	*payload = &buffer->packageArray[index].payload[buffer->nofBytesSentOfNextPayload];
+	*nofBytes = buffer->packageArray[index].payloadSize - buffer->nofBytesSentOfNextPayload;
+	return true;
+}
+
+/*!
+* \fn bool reorderBuffer_consumeOrderedPayload(tReorderBuffer* buffer, uint16_t nofBytes)
+* \brief Marks nofBytes of the next payload in order as pushed out. When the whole payload is pushed out,
+*  the package is freed and the next package in order becomes available.
+* \return true if the payload was pushed out completely
+*/
+bool reorderBuffer_consumeOrderedPayload(tReorderBuffer* buffer, uint16_t nofBytes)
+{
+	uint16_t index = getIndexOfPayloadNr(buffer->payloadNrLastInOrder + 1);
+
+	if(buffer->indexIsEmpty[index])
+	{
+		return false;
+	}
+	buffer->nofBytesSentOfNextPayload += nofBytes;
+	if(buffer->nofBytesSentOfNextPayload < buffer->packageArray[index].payloadSize)
+	{
+		return false; /* continue with the rest of this payload next time */
+	}
+	freeIndex(buffer, index);
+	buffer->payloadNrLastInOrder ++;
+	buffer->nofBytesSentOfNextPayload = 0;
+	return true;
+}
+
+/*!
+* \fn bool reorderBuffer_skipToPackageOlderThanTimeout(tReorderBuffer* buffer, uint16_t timeOutTicks, tWirelessPackage* packet)
+* \brief If the next package in order is missing and a package ahead of it was longer in the buffer than timeOutTicks,
+*  the gap is given up: the package is taken out of the buffer and the ordering continues after it.
+*  Needs to be freed after usage!
+* \return true if a package was taken out of the buffer
+*/
+bool reorderBuffer_skipToPackageOlderThanTimeout(tReorderBuffer* buffer, uint16_t timeOutTicks, tWirelessPackage* packet)
+{
+	if(buffer->count == 0 || !buffer->indexIsEmpty[getIndexOfPayloadNr(buffer->payloadNrLastInOrder + 1)])
+	{
+		return false; /* nothing stored or next package in order available */
+	}
+	/* find the first stored package after the gap */
+	for(uint16_t distance = 2 ; distance <= REORDER_BUFFER_SIZE ; distance ++)
+	{
+		uint16_t payloadNr = buffer->payloadNrLastInOrder + distance;
+		uint16_t index = getIndexOfPayloadNr(payloadNr);
+		if(!buffer->indexIsEmpty[index])
+		{
+			if((TickType_t)(xTaskGetTickCount() - buffer->tickTimestampBufferInsertion[index]) <= timeOutTicks)
+			{
+				return false;
+			}
+			*packet = buffer->packageArray[index];
+			buffer->indexIsEmpty[index] = true;
+			buffer->packageArray[index].payload = NULL;
+			buffer->count --;
+			buffer->payloadNrLastInOrder = payloadNr;
+			buffer->nofBytesSentOfNextPayload = 0;
+			return true;
+		}
+	}
+	return false;
+}
+
+/*!
+* \fn uint16_t reorderBuffer_getCurrentPayloadNR(tReorderBuffer* buffer)
+* \brief returns the payloadNr of the last package which was pushed out in order
+*/
+uint16_t reorderBuffer_getCurrentPayloadNR(tReorderBuffer* buffer)
+{
+	return buffer->payloadNrLastInOrder;
+}
+
+/*!
+* \fn static uint16_t getIndexOfPayloadNr(uint16_t payloadNr)
+* \brief returns the index in the ring where the package with this payloadNr is stored
+*/
+static uint16_t getIndexOfPayloadNr(uint16_t payloadNr)
+{
+	return payloadNr & (REORDER_BUFFER_SIZE - 1);
+}
+
+/*!
+* \fn static void freeIndex(tReorderBuffer* buffer, uint16_t index)
+* \brief frees the payload of the package at index and marks the index as empty
+*/
+static void freeIndex(tReorderBuffer* buffer, uint16_t index)
+{
+	vPortFree(buffer->packageArray[index].payload);
+	buffer->packageArray[index].payload = NULL;
+	buffer->indexIsEmpty[index] = true;
+	buffer->tickTimestampBufferInsertion[index] = 0;
+	buffer->count --;
+}
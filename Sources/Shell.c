@@ -22,9 +22,13 @@
 #endif
 #include "KIN1.h"
 #include "Config.h"
+#include "NetworkMetrics.h"
+#include "UTIL1.h"
+#include "XF1.h"
 
 /* prototypes */
 void pullMsgFromQueueAndPrint(void);
+static uint8_t NetworkMetrics_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io);
 
 /* global variables */
 static unsigned char localConsole_buf[48];
@@ -52,6 +56,7 @@ static const CLS1_ParseCommandCallback CmdParserTable[] =
 #if KIN1_PARSE_COMMAND_ENABLED
   KIN1_ParseCommand,
 #endif
+  NetworkMetrics_ParseCommand,
   NULL /* Sentinel */
 };
 
@@ -168,3 +173,38 @@ BaseType_t pushMsgToShellQueue(char* pMsg)
 	}
 	return pdTRUE; /* also return success if debug output not enabled */
 }
+
+/*!
+* \fn static uint8_t NetworkMetrics_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io)
+* \brief Shell command "metrics dump": prints the metrics snapshot with one line per wireless link, e.g.
+*  "link=0 route=1 state=1 used=1 rtt=25/31 sbpp=1830/1702 plr=12 cpp=1 q=412 qp=380 age=140"
+*  (raw/filtered RTT [ms] and SBPP [Byte/s], PLR [per mille], predicted Q, age of the metrics [ms]).
+*  Printed directly and independent of GENERATE_DEBUG_OUTPUT, so it can be polled by a script.
+*/
+static uint8_t NetworkMetrics_ParseCommand(const unsigned char *cmd, bool *handled, const CLS1_StdIOType *io)
+{
+	tLinkMetrics linkMetrics[NUMBER_OF_UARTS];
+	char buf[120];
+
+	if(UTIL1_strcmp((char*)cmd, CLS1_CMD_HELP) == 0 || UTIL1_strcmp((char*)cmd, "metrics help") == 0)
+	{
+		CLS1_SendHelpStr((unsigned char*)"metrics", (const unsigned char*)"Group of network metrics commands\r\n", io->stdOut);
+		CLS1_SendHelpStr((unsigned char*)"  help", (const unsigned char*)"Print help information\r\n", io->stdOut);
+		CLS1_SendHelpStr((unsigned char*)"  dump", (const unsigned char*)"Print the metrics and routing state, one line per wireless link\r\n", io->stdOut);
+		*handled = TRUE;
+	}
+	else if(UTIL1_strcmp((char*)cmd, "metrics dump") == 0)
+	{
+		networkMetrics_getSnapshot(linkMetrics);
+		for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
+		{
+			XF1_xsprintf(buf, "link=%u route=%u state=%u used=%u rtt=%u/%u sbpp=%u/%u plr=%u cpp=%u q=%u qp=%u age=%u\r\n",
+					i, linkMetrics[i].routingState, linkMetrics[i].linkState, linkMetrics[i].used,
+					linkMetrics[i].RTTraw, linkMetrics[i].RTTfiltered, linkMetrics[i].SBPPraw, linkMetrics[i].SBPPfiltered,
+					linkMetrics[i].PLR, linkMetrics[i].CPP, linkMetrics[i].Q, linkMetrics[i].Qpredicted, linkMetrics[i].lastUpdateAge);
+			CLS1_SendStr((unsigned char*)buf, io->stdOut);
+		}
+		*handled = TRUE;
+	}
+	return ERR_OK;
+}
@@ -16,6 +16,7 @@
 #include "Platform.h"
 #include "Logger.h"
 #include "TestBenchModemSimulation.h"
+#include "TransportHandler.h" // to notify the transport handler about received device bytes
 
 #if PL_HAS_PERCEPIO
 #include "PTRC1.h"
@@ -33,6 +34,9 @@
 #if PL_HAS_PERCEPIO
 traceString userEvent[NUMBER_OF_EVENT_CHANNELS];
 #endif
+static uint8_t txFifoLevel[NOF_SPI_SLAVES][NUMBER_OF_UARTS]; /* bytes in the MAX14830 TX FIFO after the last write */
+static TickType_t tickTimeTxFifoLevel[NOF_SPI_SLAVES][NUMBER_OF_UARTS]; /* when txFifoLevel was updated */
+static TaskHandle_t spiHandlerTaskHandle = NULL; /* to wake up the task when bytes are ready for transmission */
 static xQueueHandle TxWirelessBytes[NUMBER_OF_UARTS]; /* Incoming data from wireless side stored here */
 static xQueueHandle RxWirelessBytes[NUMBER_OF_UARTS]; /* Outgoing data to wireless side stored here */
 static xQueueHandle TxDeviceBytes[NUMBER_OF_UARTS]; /* Incoming data from device side stored here */
@@ -71,6 +75,33 @@ void spiHandler_TaskEntry(void* p)
 	const TickType_t taskInterval = pdMS_TO_TICKS(config.SpiHandlerTaskInterval);
 	TickType_t lastWakeTime = xTaskGetTickCount(); /* Initialize the xLastWakeTime variable with the current time. */
 
+	spiHandler_initMax14830();
+
+	spiHandlerTaskHandle = xTaskGetCurrentTaskHandle();
+
+	for(;;)
+	{
+		/* Wait for the next cycle */
+		if(config.EventDrivenTasks)
+		{
+			ulTaskNotifyTake(pdTRUE, taskInterval); /* HW buffers are still polled every cycle, bytes to transmit wake up the task earlier */
+		}
+		else
+		{
+			vTaskDelayUntil( &lastWakeTime, taskInterval );
+		}
+		spiHandler_readHwBufs();
+		spiHandler_writeHwBufs();
+	}
+}
+
+/*!
+* \fn void spiHandler_initMax14830(void)
+* \brief Resets both MAX14830 and configures baud rates, clock source and word length.
+* Needs to be called from a task because it waits for the MAX14830 to get ready.
+*/
+void spiHandler_initMax14830(void)
+{
 	/*
 		Initialize MAX14830's:
 		- Reset (pull reset signal down)
@@ -130,52 +161,84 @@ void spiHandler_TaskEntry(void* p)
 
 		/* Set word length and number of stop bits */
 		spiWriteToAllUartInterfaces(MAX_REG_LCR, 0x03);
+}
 
+/*!
+* \fn void spiHandler_readHwBufs(void)
+* \brief Reads the received bytes of all UARTs on both MAX14830 into the RX byte queues
+*/
+void spiHandler_readHwBufs(void)
+{
+	uint16_t nofReadBytes;
 
-	for(;;)
+	for(int uartNr = 0; uartNr < NUMBER_OF_UARTS; uartNr++)
 	{
-		/* Wait for the next cycle */
-		vTaskDelayUntil( &lastWakeTime, taskInterval );
-		/* read all data and write it to queue */
-		for(int uartNr = 0; uartNr < NUMBER_OF_UARTS; uartNr++)
+		/* read data from device spi interface */
+		if(config.EnableStressTest)
 		{
-			//vTracePrint(userEvent[0], "6");
-			/* read data from device spi interface */
-			if(config.EnableStressTest)
-			{
-				generateDebugData(RxDeviceBytes[uartNr], uartNr);
-			}
-			else
+			generateDebugData(RxDeviceBytes[uartNr], uartNr);
+		}
+		else
+		{
+			nofReadBytes = readHwBufAndWriteToQueue(MAX_14830_DEVICE_SIDE, uartNr, RxDeviceBytes[uartNr]);
+			numberOfRxBytesHwBuf[MAX_14830_DEVICE_SIDE][uartNr] += nofReadBytes;
+			if(nofReadBytes > 0)
 			{
-				numberOfRxBytesHwBuf[MAX_14830_DEVICE_SIDE][uartNr] += readHwBufAndWriteToQueue(MAX_14830_DEVICE_SIDE, uartNr, RxDeviceBytes[uartNr]);
+				transportHandler_notify();
 			}
+		}
 
-			/* write data from queue to device spi interface */
-			if(config.TestHwLoopbackOnly)
-			{
-				readQueueAndWriteToHwBuf(MAX_14830_DEVICE_SIDE, uartNr, RxDeviceBytes[uartNr], HW_FIFO_SIZE);
-			}
-			else
-			{
-				numberOfTxBytesHwBuf[MAX_14830_DEVICE_SIDE][uartNr] += readQueueAndWriteToHwBuf(MAX_14830_DEVICE_SIDE, uartNr, TxDeviceBytes[uartNr], uxQueueMessagesWaiting(TxDeviceBytes[uartNr]) );
-			}
+		/* read data from wireless spi interface */
+		nofReadBytes = readHwBufAndWriteToQueue(MAX_14830_WIRELESS_SIDE, uartNr, RxWirelessBytes[uartNr]);
+		numberOfRxBytesHwBuf[MAX_14830_WIRELESS_SIDE][uartNr] += nofReadBytes;
+		if(nofReadBytes > 0)
+		{
+			packageHandler_notify();
+		}
+	}
+}
 
-			/* read data from wireless spi interface */
-			numberOfRxBytesHwBuf[MAX_14830_WIRELESS_SIDE][uartNr] += readHwBufAndWriteToQueue(MAX_14830_WIRELESS_SIDE, uartNr, RxWirelessBytes[uartNr]);
-			/* write data from queue to wireless spi interface */
-			if(config.TestHwLoopbackOnly)
-			{
-				readQueueAndWriteToHwBuf(MAX_14830_WIRELESS_SIDE, uartNr, RxWirelessBytes[uartNr], HW_FIFO_SIZE);
-			}
-			else
-			{
-				numberOfTxBytesHwBuf[MAX_14830_WIRELESS_SIDE][uartNr] += readQueueAndWriteToHwBuf(MAX_14830_WIRELESS_SIDE, uartNr, TxWirelessBytes[uartNr], uxQueueMessagesWaiting(TxWirelessBytes[uartNr]) );
-			}
-			//vTracePrint(userEvent[0], "8");
+/*!
+* \fn void spiHandler_writeHwBufs(void)
+* \brief Writes the bytes of the TX byte queues of all UARTs on both MAX14830 into the HW buffers
+*/
+void spiHandler_writeHwBufs(void)
+{
+	for(int uartNr = 0; uartNr < NUMBER_OF_UARTS; uartNr++)
+	{
+		/* write data from queue to device spi interface */
+		if(config.TestHwLoopbackOnly)
+		{
+			readQueueAndWriteToHwBuf(MAX_14830_DEVICE_SIDE, uartNr, RxDeviceBytes[uartNr], HW_FIFO_SIZE);
+		}
+		else
+		{
+			numberOfTxBytesHwBuf[MAX_14830_DEVICE_SIDE][uartNr] += readQueueAndWriteToHwBuf(MAX_14830_DEVICE_SIDE, uartNr, TxDeviceBytes[uartNr], uxQueueMessagesWaiting(TxDeviceBytes[uartNr]) );
+		}
+
+		/* write data from queue to wireless spi interface */
+		if(config.TestHwLoopbackOnly)
+		{
+			readQueueAndWriteToHwBuf(MAX_14830_WIRELESS_SIDE, uartNr, RxWirelessBytes[uartNr], HW_FIFO_SIZE);
+		}
+		else
+		{
+			numberOfTxBytesHwBuf[MAX_14830_WIRELESS_SIDE][uartNr] += readQueueAndWriteToHwBuf(MAX_14830_WIRELESS_SIDE, uartNr, TxWirelessBytes[uartNr], uxQueueMessagesWaiting(TxWirelessBytes[uartNr]) );
 		}
 	}
 }
 
+/*!
+* \fn void spiHandler_notify(void)
+* \brief Wakes up the SPI handler task when EVENT_DRIVEN_TASKS is configured. Called by the tasks which put work into its queues.
+*/
+void spiHandler_notify(void)
+{
+	if(config.EventDrivenTasks && (spiHandlerTaskHandle != NULL))
+	{
+		xTaskNotifyGive(spiHandlerTaskHandle);
+	}
+}
 
 /*!
 * \fn void spiHandler_TaskInit(void)
@@ -530,6 +593,8 @@ static uint16_t readHwBufAndWriteToQueue(tSpiSlaves spiSlave, tUartNr uartNr, xQ
 			}
 #endif
 			int nofErrors = golay_decode(nofReadBytesToProcess, &encodedBuf[1], &buffer[1]);
+			numberOfGolayCorrectedWords[uartNr] += nofErrors;
+			numberOfGolayDecodedWords[uartNr] += nofReadBytesToProcess / 3; /* 6 coded bytes hold two 12 bit words */
 			nofReadBytesToProcess = nofReadBytesToProcess / 2; /* Golay doubled the data rate -> after decoding, only half is actual data */
 		}
 		else /* golay not used on this UART */
@@ -671,6 +736,8 @@ static uint16_t readQueueAndWriteToHwBuf(tSpiSlaves spiSlave, tUartNr uartNr, xQ
 	/* check how much space there is left in hardware buffer */
 	uint8_t spaceTakenInHwBuf = spiSingleReadTransfer(spiSlave, uartNr, MAX_REG_TX_FIFO_LVL);
 	uint8_t spaceLeftInHwBuf = HW_FIFO_SIZE - spaceTakenInHwBuf;
+	txFifoLevel[spiSlave][uartNr] = spaceTakenInHwBuf;
+	tickTimeTxFifoLevel[spiSlave][uartNr] = xTaskGetTickCount();
 	if(spiSlave == MAX_14830_WIRELESS_SIDE && config.UseGolayPerWlConn[uartNr]) /* golay enabled for this uart? */
 	{
 		spaceLeftInHwBuf /= 2; /* golay doubles the data rate */
@@ -795,6 +862,7 @@ static uint16_t readQueueAndWriteToHwBuf(tSpiSlaves spiSlave, tUartNr uartNr, xQ
 #endif
 			spiTransfer(spiSlave, uartNr, MAX_REG_RHR_THR, WRITE_TRANSFER, buffer, cnt-1);
 		}
+		txFifoLevel[spiSlave][uartNr] += cnt-1;
 		/* reenable transmission */
 		if (spiSlave == MAX_14830_DEVICE_SIDE)
 		{
@@ -916,3 +984,29 @@ uint16_t freeSpaceInTxByteQueue(tSpiSlaves spiSlave, tUartNr uartNr)
 		return (spiSlave == MAX_14830_WIRELESS_SIDE)? (BYTE_QUEUE_SIZE - ((uint16_t) uxQueueMessagesWaiting(TxWirelessBytes[uartNr]))) :  (BYTE_QUEUE_SIZE - ((uint16_t) uxQueueMessagesWaiting(TxDeviceBytes[uartNr])));
 	return 0; /* if uartNr was not in range */
 }
+
+/*!
+* \fn uint16_t numberOfBytesWaitingForTx(tSpiSlaves spiSlave, tUartNr uartNr)
+* \brief Returns the transmit backlog of a UART: the bytes in the TX byte queue plus the bytes in the MAX14830 TX FIFO.
+* The FIFO level is the one read at the last write to the FIFO, reduced by the bytes the UART sent out since then.
+* \param uartNr: UART number the bytes should be transmitted to.
+* \param spiSlave: spiSlave byte should be sent to.
+* \return Number of bytes waiting to be sent out
+*/
+uint16_t numberOfBytesWaitingForTx(tSpiSlaves spiSlave, tUartNr uartNr)
+{
+	uint32_t baudRate;
+	uint32_t nofBytesSentSinceUpdate;
+	uint16_t nofBytesInHwBuf = 0;
+
+	if(uartNr >= NUMBER_OF_UARTS)
+		return 0;
+
+	baudRate = (spiSlave == MAX_14830_WIRELESS_SIDE)? config.BaudRatesWirelessConn[uartNr] : config.BaudRatesDeviceConn[uartNr];
+	nofBytesSentSinceUpdate = ((xTaskGetTickCount() - tickTimeTxFifoLevel[spiSlave][uartNr]) * portTICK_PERIOD_MS * (baudRate / 10)) / 1000; /* 10 bits per UART byte */
+	if(nofBytesSentSinceUpdate < txFifoLevel[spiSlave][uartNr])
+	{
+		nofBytesInHwBuf = txFifoLevel[spiSlave][uartNr] - nofBytesSentSinceUpdate;
+	}
+	return numberOfBytesInTxByteQueue(spiSlave, uartNr) + nofBytesInHwBuf;
+}
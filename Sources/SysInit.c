@@ -10,6 +10,7 @@
 #include "TestBenchMaster.h"
 #include "TransportHandler.h"
 #include "Blinky.h"
+#include "Pipeline.h"
 #include "ThroughputPrintout.h"
 #include "Logger.h"
 #include "SysInit.h"
@@ -61,6 +62,7 @@ static bool createAllTasks(void)
 	static StackType_t puxStackBufferTestBenchMaster[TESTBENCHMASTER_STACK_SIZE];
 	static StackType_t puxStackBufferLogger[LOGGER_STACK_SIZE];
 	static StackType_t puxStackBufferBlinky[BLINKY_STACK_SIZE];
+	static StackType_t puxStackBufferPipeline[PIPELINE_STACK_SIZE];
 
 	/* Structure that will hold the TCB of the task being created. */
 	static StaticTask_t pxTaskBufferShell;
@@ -73,6 +75,7 @@ static bool createAllTasks(void)
 	static StaticTask_t pxTaskBufferTestBenchMaster;
 	static StaticTask_t pxTaskBufferLogger;
 	static StaticTask_t pxTaskBufferBlinky;
+	static StaticTask_t pxTaskBufferPipeline;
 
 
 	/* create Shell task */
@@ -82,20 +85,32 @@ static bool createAllTasks(void)
 				for(;;) {}} /* error */
 	}
 
-	/* create SPI handler task */
-	if (xTaskCreateStatic(spiHandler_TaskEntry, "SPI_Handler", SPI_HANDLER_STACK_SIZE, NULL, tskIDLE_PRIORITY+3, puxStackBufferSpiHandler, &pxTaskBufferSpiHandler) == NULL) {
-	    for(;;) {}} /* error */
+	if(config.RunToCompletionPipeline)
+	{
+		/* create single task which runs SPI, package, network and transport handler */
+		if (xTaskCreateStatic(pipeline_TaskEntry, "Pipeline", PIPELINE_STACK_SIZE, NULL, tskIDLE_PRIORITY+3, puxStackBufferPipeline, &pxTaskBufferPipeline) == NULL) {
+			for(;;) {}} /* error */
+	}
+	else
+	{
+		/* create SPI handler task */
+		if (xTaskCreateStatic(spiHandler_TaskEntry, "SPI_Handler", SPI_HANDLER_STACK_SIZE, NULL, tskIDLE_PRIORITY+3, puxStackBufferSpiHandler, &pxTaskBufferSpiHandler) == NULL) {
+			for(;;) {}} /* error */
+	}
 
 
 	/* create package handler task */
 	if(config.EnableRoutingAlgorithmTestBench != TESTBENCH_MODE_MASTER)
 	{
-		if (xTaskCreateStatic(packageHandler_TaskEntry, "Package_Handler", PACKAGE_HANDLER_STACK_SIZE, NULL, tskIDLE_PRIORITY+2, puxStackBufferPackageHandler, &pxTaskBufferPackageHandler) == NULL) {
-			for(;;) {}} /* error */
+		if(!config.RunToCompletionPipeline)
+		{
+			if (xTaskCreateStatic(packageHandler_TaskEntry, "Package_Handler", PACKAGE_HANDLER_STACK_SIZE, NULL, tskIDLE_PRIORITY+2, puxStackBufferPackageHandler, &pxTaskBufferPackageHandler) == NULL) {
+				for(;;) {}} /* error */
 
-		/* create network handler task */
-		if (xTaskCreateStatic(networkHandler_TaskEntry, "Network_Handler", NETWORK_HANDLER_STACK_SIZE, NULL, tskIDLE_PRIORITY+2, puxStackBufferNetworkHandler, &pxTaskBufferNetworkHandler) == NULL) {
-			for(;;) {}} /* error */
+			/* create network handler task */
+			if (xTaskCreateStatic(networkHandler_TaskEntry, "Network_Handler", NETWORK_HANDLER_STACK_SIZE, NULL, tskIDLE_PRIORITY+2, puxStackBufferNetworkHandler, &pxTaskBufferNetworkHandler) == NULL) {
+				for(;;) {}} /* error */
+		}
 
 
 		if(config.RoutingMethode == ROUTING_METHODE_METRICS)
@@ -107,8 +122,11 @@ static bool createAllTasks(void)
 
 
 		/* create network handler task */
-		if (xTaskCreateStatic(transportHandler_TaskEntry, "Transport_Handler", TRANSPORT_HANDLER_STACK_SIZE, NULL, tskIDLE_PRIORITY+2, puxStackBufferTransportHandler, &pxTaskBufferTransportHandler) == NULL) {
-			for(;;) {}} /* error */
+		if(!config.RunToCompletionPipeline)
+		{
+			if (xTaskCreateStatic(transportHandler_TaskEntry, "Transport_Handler", TRANSPORT_HANDLER_STACK_SIZE, NULL, tskIDLE_PRIORITY+2, puxStackBufferTransportHandler, &pxTaskBufferTransportHandler) == NULL) {
+				for(;;) {}} /* error */
+		}
 
 		/* create throughput printout task */
 		if(config.GenerateDebugOutput == DEBUG_OUTPUT_FULLLY_ENABLED)
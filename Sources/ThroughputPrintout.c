@@ -20,6 +20,19 @@ long unsigned int numberOfDroppedBytes[NOF_SPI_SLAVES][NUMBER_OF_UARTS];
 long unsigned int numberOfInvalidPackages[NUMBER_OF_UARTS];
 long unsigned int numberOfRxBytesHwBuf[NOF_SPI_SLAVES][NUMBER_OF_UARTS];
 long unsigned int numberOfTxBytesHwBuf[NOF_SPI_SLAVES][NUMBER_OF_UARTS];
+long unsigned int numberOfPacksInReorderBuffer[NUMBER_OF_UARTS];
+long unsigned int maxNumberOfPacksInReorderBuffer[NUMBER_OF_UARTS];
+long unsigned int numberOfRebuiltPacks[NUMBER_OF_UARTS];
+long unsigned int numberOfSuppressedDuplicates[NUMBER_OF_UARTS];
+long unsigned int numberOfDispatchStalls[NUMBER_OF_UARTS];
+long unsigned int numberOfProbeBytesSaved[NUMBER_OF_UARTS];
+long unsigned int numberOfLinkStateTransitions[NUMBER_OF_UARTS];
+long unsigned int numberOfLinkRoutingTransitions[NUMBER_OF_UARTS];
+long unsigned int numberOfGolayDecodedWords[NUMBER_OF_UARTS];
+long unsigned int numberOfGolayCorrectedWords[NUMBER_OF_UARTS];
+long unsigned int queueingDelaySum[NUMBER_OF_UARTS];
+long unsigned int numberOfQueueingDelaySamples[NUMBER_OF_UARTS];
+long unsigned int maxQueueingDelay[NUMBER_OF_UARTS];
 
 void throughputPrintout_TaskEntry(void* p)
 {
@@ -36,6 +49,10 @@ void throughputPrintout_TaskEntry(void* p)
 	static unsigned int averageAcksReceived[NUMBER_OF_UARTS];
 	static unsigned int averageUartBytesSent[NOF_SPI_SLAVES][NUMBER_OF_UARTS];
 	static unsigned int averageUartBytesReceived[NOF_SPI_SLAVES][NUMBER_OF_UARTS];
+	static unsigned int linkStateTransitionsPerMinute[NUMBER_OF_UARTS];
+	static unsigned int linkRoutingTransitionsPerMinute[NUMBER_OF_UARTS];
+	/* queueing delay per QoS class */
+	long unsigned int classQueueingDelaySum[NOF_QOS_CLASSES], classQueueingDelaySamples[NOF_QOS_CLASSES], classMaxQueueingDelay[NOF_QOS_CLASSES];
 	/* so the global variables do not have to be reset */
 	static long unsigned int lastNumberOfPacksReceived[NUMBER_OF_UARTS];
 	static long unsigned int lastNumberOfPacksSent[NUMBER_OF_UARTS];
@@ -45,6 +62,10 @@ void throughputPrintout_TaskEntry(void* p)
 	static long unsigned int lastNumberOfPayloadBytesSent[NUMBER_OF_UARTS];
 	static long unsigned int lastNumberOfUartBytesSent[NOF_SPI_SLAVES][NUMBER_OF_UARTS];
 	static long unsigned int lastNumberOfUartBytesReceived[NOF_SPI_SLAVES][NUMBER_OF_UARTS];
+	static long unsigned int lastNumberOfLinkStateTransitions[NUMBER_OF_UARTS];
+	static long unsigned int lastNumberOfLinkRoutingTransitions[NUMBER_OF_UARTS];
+	static long unsigned int lastQueueingDelaySum[NUMBER_OF_UARTS];
+	static long unsigned int lastNumberOfQueueingDelaySamples[NUMBER_OF_UARTS];
 
 	for(;;)
 	{
@@ -62,9 +83,29 @@ void throughputPrintout_TaskEntry(void* p)
 			averageUartBytesReceived[MAX_14830_WIRELESS_SIDE][cnt] = (unsigned int) ((numberOfRxBytesHwBuf[MAX_14830_WIRELESS_SIDE][cnt] - lastNumberOfUartBytesReceived[MAX_14830_WIRELESS_SIDE][cnt])/config.ThroughputPrintoutTaskInterval_s);
 			averagePayloadReceived[cnt] = (numberOfPayloadBytesExtracted[cnt]-lastNumberOfPayloadBytesExtracted[cnt])/(numberOfPacksReceived[cnt]-lastNumberOfPacksReceived[cnt]);
 			averagePayloadSent[cnt] = (numberOfPayloadBytesSent[cnt]-lastNumberOfPayloadBytesSent[cnt])/(numberOfPacksSent[cnt]-lastNumberOfPacksSent[cnt]);
+			linkStateTransitionsPerMinute[cnt] = (numberOfLinkStateTransitions[cnt]-lastNumberOfLinkStateTransitions[cnt])*60/config.ThroughputPrintoutTaskInterval_s;
+			linkRoutingTransitionsPerMinute[cnt] = (numberOfLinkRoutingTransitions[cnt]-lastNumberOfLinkRoutingTransitions[cnt])*60/config.ThroughputPrintoutTaskInterval_s;
 
 		}
 
+		for(int qosClass = 0; qosClass < NOF_QOS_CLASSES; qosClass++)
+		{
+			classQueueingDelaySum[qosClass] = 0;
+			classQueueingDelaySamples[qosClass] = 0;
+			classMaxQueueingDelay[qosClass] = 0;
+		}
+		for(int cnt = 0; cnt < NUMBER_OF_UARTS; cnt++)
+		{
+			int qosClass = config.QosClass[cnt];
+			classQueueingDelaySum[qosClass] += queueingDelaySum[cnt] - lastQueueingDelaySum[cnt];
+			classQueueingDelaySamples[qosClass] += numberOfQueueingDelaySamples[cnt] - lastNumberOfQueueingDelaySamples[cnt];
+			if(maxQueueingDelay[cnt] > classMaxQueueingDelay[qosClass])
+			{
+				classMaxQueueingDelay[qosClass] = maxQueueingDelay[cnt];
+			}
+			maxQueueingDelay[cnt] = 0; /* peak per printout interval */
+		}
+
 		res = XF1_xsprintf(buf, "***************************************************************************************************** \r\n");
 		res = pushMsgToShellQueue(buf);
 		/* print throughput information */
@@ -146,6 +187,19 @@ void throughputPrintout_TaskEntry(void* p)
 				numberOfDroppedAcks[0], numberOfDroppedAcks[1], numberOfDroppedAcks[2], numberOfDroppedAcks[3]);
 		res = pushMsgToShellQueue(buf);
 
+		res = XF1_xsprintf(buf, "NetworkHandler: Total number of dispatch stalls (no space on the chosen links) per device: %lu,%lu,%lu,%lu \r\n",
+				numberOfDispatchStalls[0], numberOfDispatchStalls[1], numberOfDispatchStalls[2], numberOfDispatchStalls[3]);
+		res = pushMsgToShellQueue(buf);
+
+		res = XF1_xsprintf(buf, "NetworkHandler: Queueing delay per QoS class (average/peak): strict priority %lu/%lu ms, weighted fair %lu/%lu ms \r\n",
+				(classQueueingDelaySamples[QOS_CLASS_STRICT_PRIORITY] > 0) ? classQueueingDelaySum[QOS_CLASS_STRICT_PRIORITY] / classQueueingDelaySamples[QOS_CLASS_STRICT_PRIORITY] : 0, classMaxQueueingDelay[QOS_CLASS_STRICT_PRIORITY],
+				(classQueueingDelaySamples[QOS_CLASS_WEIGHTED_FAIR] > 0) ? classQueueingDelaySum[QOS_CLASS_WEIGHTED_FAIR] / classQueueingDelaySamples[QOS_CLASS_WEIGHTED_FAIR] : 0, classMaxQueueingDelay[QOS_CLASS_WEIGHTED_FAIR]);
+		res = pushMsgToShellQueue(buf);
+
+		res = XF1_xsprintf(buf, "NetworkHandler: Total number of suppressed duplicate packages per wireless input: %lu,%lu,%lu,%lu \r\n",
+				numberOfSuppressedDuplicates[0], numberOfSuppressedDuplicates[1], numberOfSuppressedDuplicates[2], numberOfSuppressedDuplicates[3]);
+		res = pushMsgToShellQueue(buf);
+
 		res = XF1_xsprintf(buf, "PackageHandler: Total number of invalid packages per wireless input: %lu,%lu,%lu,%lu \r\n",
 				numberOfInvalidPackages[0], numberOfInvalidPackages[1], numberOfInvalidPackages[2], numberOfInvalidPackages[3]);
 		res = pushMsgToShellQueue(buf);
@@ -154,10 +208,36 @@ void throughputPrintout_TaskEntry(void* p)
 				numberOfDroppedBytes[MAX_14830_DEVICE_SIDE][0], numberOfDroppedBytes[MAX_14830_DEVICE_SIDE][1], numberOfDroppedBytes[MAX_14830_DEVICE_SIDE][2], numberOfDroppedBytes[MAX_14830_DEVICE_SIDE][3]);
 		res = pushMsgToShellQueue(buf);
 
-		res = XF1_xsprintf(buf, "SpiHandler: Total number of dropped bytes per wireless byte input: %lu,%lu,%lu,%lu \r\n\r\n",
+		res = XF1_xsprintf(buf, "SpiHandler: Total number of dropped bytes per wireless byte input: %lu,%lu,%lu,%lu \r\n",
 				numberOfDroppedBytes[MAX_14830_WIRELESS_SIDE][0], numberOfDroppedBytes[MAX_14830_WIRELESS_SIDE][1], numberOfDroppedBytes[MAX_14830_WIRELESS_SIDE][2], numberOfDroppedBytes[MAX_14830_WIRELESS_SIDE][3]);
 		res = pushMsgToShellQueue(buf);
 
+		res = XF1_xsprintf(buf, "SpiHandler: Total number of Golay corrected 12 bit words per wireless input: %lu,%lu,%lu,%lu \r\n",
+				numberOfGolayCorrectedWords[0], numberOfGolayCorrectedWords[1], numberOfGolayCorrectedWords[2], numberOfGolayCorrectedWords[3]);
+		res = pushMsgToShellQueue(buf);
+
+		res = XF1_xsprintf(buf, "NetworkMetrics: Total number of probe bytes saved by passive metrics per wireless link: %lu,%lu,%lu,%lu \r\n",
+				numberOfProbeBytesSaved[0], numberOfProbeBytesSaved[1], numberOfProbeBytesSaved[2], numberOfProbeBytesSaved[3]);
+		res = pushMsgToShellQueue(buf);
+
+		res = XF1_xsprintf(buf, "NetworkMetrics: Link state transitions per minute per wireless link (Q state/used by routing): %u/%u,%u/%u,%u/%u,%u/%u \r\n",
+				linkStateTransitionsPerMinute[0], linkRoutingTransitionsPerMinute[0], linkStateTransitionsPerMinute[1], linkRoutingTransitionsPerMinute[1],
+				linkStateTransitionsPerMinute[2], linkRoutingTransitionsPerMinute[2], linkStateTransitionsPerMinute[3], linkRoutingTransitionsPerMinute[3]);
+		res = pushMsgToShellQueue(buf);
+
+		res = XF1_xsprintf(buf, "TransportHandler: Total number of packages rebuilt from parity packages per device: %lu,%lu,%lu,%lu \r\n",
+				numberOfRebuiltPacks[0], numberOfRebuiltPacks[1], numberOfRebuiltPacks[2], numberOfRebuiltPacks[3]);
+		res = pushMsgToShellQueue(buf);
+
+		res = XF1_xsprintf(buf, "TransportHandler: Packages waiting in reorder buffer per device (current/peak): %lu/%lu,%lu/%lu,%lu/%lu,%lu/%lu \r\n\r\n",
+				numberOfPacksInReorderBuffer[0], maxNumberOfPacksInReorderBuffer[0], numberOfPacksInReorderBuffer[1], maxNumberOfPacksInReorderBuffer[1],
+				numberOfPacksInReorderBuffer[2], maxNumberOfPacksInReorderBuffer[2], numberOfPacksInReorderBuffer[3], maxNumberOfPacksInReorderBuffer[3]);
+		res = pushMsgToShellQueue(buf);
+		for(int cnt = 0; cnt < NUMBER_OF_UARTS; cnt++)
+		{
+			maxNumberOfPacksInReorderBuffer[cnt] = numberOfPacksInReorderBuffer[cnt]; /* peak per printout interval */
+		}
+
 		res = XF1_xsprintf(buf, "***************************************************************************************************** \r\n");
 		res = pushMsgToShellQueue(buf);
 
@@ -247,6 +327,10 @@ void throughputPrintout_TaskEntry(void* p)
 			lastNumberOfUartBytesSent[MAX_14830_DEVICE_SIDE][cnt] = numberOfTxBytesHwBuf[MAX_14830_DEVICE_SIDE][cnt];
 			lastNumberOfUartBytesReceived[MAX_14830_WIRELESS_SIDE][cnt] = numberOfRxBytesHwBuf[MAX_14830_WIRELESS_SIDE][cnt];
 			lastNumberOfUartBytesSent[MAX_14830_WIRELESS_SIDE][cnt] = numberOfTxBytesHwBuf[MAX_14830_WIRELESS_SIDE][cnt];
+			lastNumberOfLinkStateTransitions[cnt] = numberOfLinkStateTransitions[cnt];
+			lastNumberOfLinkRoutingTransitions[cnt] = numberOfLinkRoutingTransitions[cnt];
+			lastQueueingDelaySum[cnt] = queueingDelaySum[cnt];
+			lastNumberOfQueueingDelaySamples[cnt] = numberOfQueueingDelaySamples[cnt];
 		}
 	}
 }
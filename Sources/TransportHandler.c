@@ -18,6 +18,8 @@
 #include "LedRed.h"
 #include "Platform.h"
 #include "PackageBuffer.h"
+#include "ReorderBuffer.h"
+#include "ParityFec.h"
 #include "Logger.h"
 #include "PanicButton.h"
 
@@ -25,10 +27,10 @@
 static bool processReceivedPayload(tWirelessPackage* pPackage);
 static bool generateDataPackage(tUartNr deviceNr, tWirelessPackage* pPackage);
 static bool generateAckPackage(tWirelessPackage* pReceivedDataPack, tWirelessPackage* pAckPack);
-static void sendOutTestPackagePair(tUartNr deviceNr, tWirelessPackage* pPackage);
+static void sendOutTestPackageTrain(tUartNr deviceNr, tWirelessPackage* pPackage);
 static bool generateTestDataPackage(tUartNr deviceNr, tWirelessPackage* pPackage, bool returned,bool firstPackOfPacketPair);
 static BaseType_t pushToGeneratedPacksQueue(tUartNr uartNr, tWirelessPackage* pPackage);
-static void pushPayloadOut(tWirelessPackage* package);
+static void pushOrderedPayloadsOut(tUartNr deviceNr);
 static bool pushNextStoredPackOut(tUartNr wlConn);
 static bool pushOldestPackOutIfTimeout(tUartNr wlConn, bool forced);
 static void initTransportHandlerQueues(void);
@@ -37,6 +39,14 @@ static BaseType_t nofReceivedPayloadPacksInQueue(tUartNr uartNr);
 static BaseType_t popFromReceivedPayloadPacksQueue(tUartNr uartNr, tWirelessPackage* pPackage);
 static void checkSessionNr(tWirelessPackage* pPackage);
 static bool copyPackage(tWirelessPackage* original, tWirelessPackage* copy);
+static bool congestionWindowIsFull(tUartNr deviceNr);
+static uint16_t getCongestionWindowLimit(tUartNr deviceNr);
+static void congestionWindowPacksAcknowledged(tUartNr deviceNr, uint16_t nofAcknowledgedPacks);
+static void congestionWindowPackTimedOut(tUartNr deviceNr, uint16_t payloadNr);
+static void updateByteArrivalRate(tUartNr deviceNr, uint16_t numberOfBytesInRxQueue);
+static uint16_t getPacketSizeToGenerate(tUartNr deviceNr);
+static void rebuildLostPackage(tUartNr deviceNr, uint16_t firstPayloadNr, uint8_t receivedModemNr);
+static void getFecBlockSize(tUartNr deviceNr, uint8_t* groupSize, uint8_t* nofParityPacks);
 
 
 /* --------------- global variables -------------------- */
@@ -47,9 +57,18 @@ static char* queueNameReceivedPayload[] = {"queueReceivedPacksFromDev0", "queueR
 static uint16_t payloadNumTracker[NUMBER_OF_UARTS];
 static uint16_t sentAckNumTracker[NUMBER_OF_UARTS];
 static uint16_t testPackNumTracker[NUMBER_OF_UARTS];
+static uint16_t probeNumTracker[NUMBER_OF_UARTS];
 static tPackageBuffer sendBuffer[NUMBER_OF_UARTS];								/*Packets are stored which wait for the acknowledge */
-static tPackageBuffer receiveBuffer[NUMBER_OF_UARTS];							/*Packets are stored which wait for reordering */
+static tReorderBuffer receiveBuffer[NUMBER_OF_UARTS];							/*Packets are stored which wait for reordering */
 static bool remotePanicMode = false;
+static uint16_t congestionWindow[NUMBER_OF_UARTS];							/* Max number of unacknowledged data packages in flight per device */
+static uint16_t congestionWindowAckCounter[NUMBER_OF_UARTS];				/* Acknowledged packages since the last increase of the window */
+static uint16_t congestionRecoveryPayloadNr[NUMBER_OF_UARTS];				/* Packages up to this payloadNr were sent before the last decrease of the window */
+static TaskHandle_t transportHandlerTaskHandle = NULL;						/* to wake up the task when there is work in its queues */
+static uint32_t byteArrivalRate[NUMBER_OF_UARTS];							/* Filtered arrival rate of bytes on the device side [Byte/s] */
+static uint16_t nofBytesInRxQueueAfterLastCall[NUMBER_OF_UARTS];			/* To calculate how many bytes arrived since the last call of generateDataPackage() */
+static tFecEncoder fecEncoder[NUMBER_OF_UARTS];								/* Parity of the data packages sent since the last parity package */
+static tFecDecoder fecDecoder[NUMBER_OF_UARTS];								/* Parity of the received data packages to rebuild a lost one */
 
 //static uint16_t sysTimeLastPushedOutPayload[NUMBER_OF_UARTS];  Which package was last sent out [payloadNR!!!!]
 //static uint16_t minSysTimeOfStoredPackagesForReordering[NUMBER_OF_UARTS];
@@ -70,58 +89,76 @@ traceString appHandlerUserEvent[10];
 */
 void transportHandler_TaskEntry(void* p)
 {
-	static bool workaroundToStartUAVswitch = true;
 	const TickType_t taskInterval = pdMS_TO_TICKS(config.TransportHandlerTaskInterval);
+	TickType_t xLastWakeTime = xTaskGetTickCount(); /* Initialize the lastWakeTime variable with the current time. */
+
+	transportHandlerTaskHandle = xTaskGetCurrentTaskHandle();
+
+	for(;;)
+	{
+		if(config.EventDrivenTasks)
+		{
+			ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(config.EventDrivenFallbackInterval)); /* Wait for work or the fallback tick */
+		}
+		else
+		{
+			vTaskDelayUntil( &xLastWakeTime, taskInterval ); /* Wait for the next cycle */
+		}
+		transportHandler_run();
+	}
+}
+
+/*!
+* \fn void transportHandler_run(void)
+* \brief One cycle of the transport handler: generates, resends and acknowledges packages and pushes
+* received payloads in order out on the device side.
+*/
+void transportHandler_run(void)
+{
+	static bool workaroundToStartUAVswitch = true;
 	tWirelessPackage package,pAckPack;
 	bool request = true;
-	TickType_t xLastWakeTime = xTaskGetTickCount(); /* Initialize the lastWakeTime variable with the current time. */
 	uint16_t latency;
 
-	for(;;)
+	/* generate data packages and put those into the package queue */
+	for(int deviceNr = 0; deviceNr<NUMBER_OF_UARTS; deviceNr++)
 	{
-		vTaskDelayUntil( &xLastWakeTime, taskInterval ); /* Wait for the next cycle */
-		/* generate data packages and put those into the package queue */
-		for(int deviceNr = 0; deviceNr<NUMBER_OF_UARTS; deviceNr++)
+
+		/*------------------------ Generate TestPackets if requested ---------------------------*/
+		if ((popFromRequestNewTestPacketPairQueue(deviceNr, &request) == pdTRUE && config.UseProbingPacksWlConn[deviceNr] == true) || workaroundToStartUAVswitch)
 		{
+			workaroundToStartUAVswitch = false;  //Todo finde the rootcause why workaround needed...
+			sendOutTestPackageTrain(deviceNr, &package);
+		}
 
-			/*------------------------ Generate TestPackets if requested ---------------------------*/
-			if ((popFromRequestNewTestPacketPairQueue(&request) == pdTRUE && config.UseProbingPacksWlConn[deviceNr] == true) || workaroundToStartUAVswitch)
+		/*------------------ Generate Packages From Raw Data (Device Bytes)---------------------*/
+		/* If the sending window is full, the data stays in the device byte queue until acknowledges arrive */
+		if (!congestionWindowIsFull(deviceNr) && generateDataPackage(deviceNr, &package))
+		{
+
+			package.panicMode = PanicButton_GetVal();
+			package.sendAttempt = 1;
+			if(config.FecParityGroupSize[deviceNr] > 0)
 			{
-				workaroundToStartUAVswitch = false;  //Todo finde the rootcause why workaround needed...
-				sendOutTestPackagePair(deviceNr, &package);
+				uint8_t groupSize, nofParityPacks;
+				getFecBlockSize(deviceNr, &groupSize, &nofParityPacks);
+				parityFec_addDataPackage(&fecEncoder[deviceNr], &package, groupSize, nofParityPacks);
 			}
 
-			/*------------------ Generate Packages From Raw Data (Device Bytes)---------------------*/
-			if (generateDataPackage(deviceNr, &package))
+			logger_incrementDeviceSentPack(package.devNum);
+			if (packageBuffer_put(&sendBuffer[deviceNr],&package) != true)//Put data-package into sendBuffer until Acknowledge gets received
 			{
+				tWirelessPackage oldestPackage;
+				packageBuffer_getOldestPackage(&sendBuffer[deviceNr],&oldestPackage); //If buffer full, delete oldest Package
+				vPortFree(oldestPackage.payload);
+				oldestPackage.payload = NULL;
 
-				package.panicMode = PanicButton_GetVal();
-
-				logger_incrementDeviceSentPack(package.devNum);
-				if (packageBuffer_put(&sendBuffer[deviceNr],&package) != true)//Put data-package into sendBuffer until Acknowledge gets received
+				if(packageBuffer_put(&sendBuffer[deviceNr],&package) != true) //Try again to put pack into sendbuffer
 				{
-					tWirelessPackage oldestPackage;
-					packageBuffer_getOldestPackage(&sendBuffer[deviceNr],&oldestPackage); //If buffer full, delete oldest Package
-					vPortFree(oldestPackage.payload);
-					oldestPackage.payload = NULL;
-
-					if(packageBuffer_put(&sendBuffer[deviceNr],&package) != true) //Try again to put pack into sendbuffer
-					{
-						vPortFree(package.payload);
-						package.payload = NULL;
-					}
-					else if(pushToGeneratedPacksQueue(deviceNr, &package) != pdTRUE) //Put data-package into Queues
-					{
-						vPortFree(package.payload);
-						package.payload = NULL;
-						if(packageBuffer_getPackage(&sendBuffer[deviceNr],&package,package.payloadNr,&latency))
-						{
-							vPortFree(package.payload);
-							package.payload = NULL;
-						}
-					}
+					vPortFree(package.payload);
+					package.payload = NULL;
 				}
-				else if (pushToGeneratedPacksQueue(deviceNr, &package) != pdTRUE) 		//Put data-package into Queues
+				else if(pushToGeneratedPacksQueue(deviceNr, &package) != pdTRUE) //Put data-package into Queues
 				{
 					vPortFree(package.payload);
 					package.payload = NULL;
@@ -132,194 +169,240 @@ void transportHandler_TaskEntry(void* p)
 					}
 				}
 			}
+			else if (pushToGeneratedPacksQueue(deviceNr, &package) != pdTRUE) 		//Put data-package into Queues
+			{
+				vPortFree(package.payload);
+				package.payload = NULL;
+				if(packageBuffer_getPackage(&sendBuffer[deviceNr],&package,package.payloadNr,&latency))
+				{
+					vPortFree(package.payload);
+					package.payload = NULL;
+				}
+			}
+		}
 
-			/*-----------------------Handle Incoming Packages from the Modems-----------------------*/
-			while (nofReceivedPayloadPacksInQueue(deviceNr) > 0)
+		/*------------------ Generate Parity Packages when the group is complete (FEC) ---------------------*/
+		while(config.FecParityGroupSize[deviceNr] > 0 &&
+		      parityFec_generateParityPackage(&fecEncoder[deviceNr], pdMS_TO_TICKS(config.PackageGenMaxTimeout[deviceNr]), &package))
+		{
+			package.devNum = deviceNr;
+			package.panicMode = PanicButton_GetVal();
+			if (pushToGeneratedPacksQueue(deviceNr, &package) != pdTRUE)		//Parity packages are not resent, no sendBuffer needed
 			{
-				peekAtReceivedPayloadPacksQueue(deviceNr, &package);
+				vPortFree(package.payload);
+				package.payload = NULL;
+			}
+		}
+
+		/*-----------------------Handle Incoming Packages from the Modems-----------------------*/
+		while (nofReceivedPayloadPacksInQueue(deviceNr) > 0)
+		{
+			peekAtReceivedPayloadPacksQueue(deviceNr, &package);
 
-				checkSessionNr(&package);
+			checkSessionNr(&package);
 
-			/*--------------> Incoming Package == DataPackage <-----------------*/
-				if(package.packType == PACK_TYPE_DATA_PACKAGE)
+		/*--------------> Incoming Package == DataPackage <-----------------*/
+			if(package.packType == PACK_TYPE_DATA_PACKAGE)
+			{
+				remotePanicMode = package.panicMode;
+				tReorderBufferPutResult putResult = reorderBuffer_put(&receiveBuffer[deviceNr],&package);		//Put data-package into receiveBuffer
+				if(putResult == REORDER_BUFFER_PUT_NO_MEMORY)
+				{
+					break; //No memory for the payload, try again in the next cycle
+				}
+				else if(putResult == REORDER_BUFFER_PUT_DROPPED)
+				{
+					popFromReceivedPayloadPacksQueue(deviceNr, &package);		//Not acknowledged, the sender resends it
+					vPortFree(package.payload);
+					package.payload = NULL;
+				}
+				else
 				{
-					remotePanicMode = package.panicMode;
-					if(packageBuffer_putIfNotOld(&receiveBuffer[deviceNr],&package) != true)			//Put data-package into receiveBuffer
+					//Send Acknowledge for the DataPack
+					generateAckPackage(&package, &pAckPack);
+					if (pushToGeneratedPacksQueue(deviceNr, &pAckPack) != pdTRUE)		//Put ack-package into Queues
 					{
-						if(packageBuffer_getPackage(&receiveBuffer[deviceNr],&package,package.payloadNr,&latency))
-						{
-							vPortFree(package.payload);
-							package.payload = NULL;
-						}
-						break;
+						vPortFree(pAckPack.payload);
+						pAckPack.payload = NULL;
 					}
-					else
+
+					if(config.FecParityGroupSize[deviceNr] > 0)
 					{
-						//Send Acknowledge for the DataPack
-						generateAckPackage(&package, &pAckPack);
-						if (pushToGeneratedPacksQueue(deviceNr, &pAckPack) != pdTRUE)		//Put ack-package into Queues
-						{
-							vPortFree(pAckPack.payload);
-							pAckPack.payload = NULL;
-						}
-
-						popFromReceivedPayloadPacksQueue(deviceNr, &package);
-						vPortFree(package.payload);
-						package.payload = NULL;
+						parityFec_receivedDataPackage(&fecDecoder[deviceNr], &package);
+						rebuildLostPackage(deviceNr, package.packNr, package.receivedModemNr);
 					}
-				}
 
-			/*--------------> Incoming Package == Acknowledge <-----------------*/
-				else if(package.packType == PACK_TYPE_REC_ACKNOWLEDGE)
-				{
-					uint16_t payloadNrToAck = package.payloadNr;
-					uint16_t payloadNrTransmissionOk = package.packNr;
-					uint8_t wirelessConnNr = package.payload[0];
-					uint16_t numberOfSendTries;
-					bool gotApack = false;
 					popFromReceivedPayloadPacksQueue(deviceNr, &package);
 					vPortFree(package.payload);
 					package.payload = NULL;
+				}
+			}
 
-					//Delete Acknowledged package from all sendBuffer
-					packageBuffer_setCurrentPayloadNR(&sendBuffer[deviceNr],payloadNrTransmissionOk);
-					packageBuffer_freeOlderThanCurrentPackage(&sendBuffer[deviceNr]);
-					
-					while(packageBuffer_getPackageWithVar(&sendBuffer[deviceNr],&package,&numberOfSendTries,payloadNrToAck,&latency))
-					{
-						vPortFree(package.payload);
-						package.payload = NULL;
-
-						if(!gotApack)
-						{
-							gotApack = true;
-							logger_logDeviceToDeviceLatency(package.devNum,(numberOfSendTries+1)*latency);
-							logger_logModemLatency(wirelessConnNr,latency);
-						}
-					}
+		/*--------------> Incoming Package == ParityPackage <---------------*/
+			else if(package.packType == PACK_TYPE_PARITY_PACKAGE)
+			{
+				if(config.FecParityGroupSize[deviceNr] > 0)
+				{
+					parityFec_receivedParityPackage(&fecDecoder[deviceNr], &package);
+					rebuildLostPackage(deviceNr, package.packNr, package.receivedModemNr);
 				}
+				popFromReceivedPayloadPacksQueue(deviceNr, &package);
+				vPortFree(package.payload);
+				package.payload = NULL;
+			}
 
-			/*--------------> Incoming Package == NetworkTestPackage <----------*/
+		/*--------------> Incoming Package == Acknowledge <-----------------*/
+			else if(package.packType == PACK_TYPE_REC_ACKNOWLEDGE)
+			{
+				uint16_t payloadNrToAck = package.payloadNr;
+				uint16_t payloadNrTransmissionOk = package.packNr;
+				uint8_t wirelessConnNr = package.payload[0];
+				uint16_t numberOfSendTries;
+				bool gotApack = false;
+				size_t nofPacksInFlight = sendBuffer[deviceNr].count;
+				popFromReceivedPayloadPacksQueue(deviceNr, &package);
+				vPortFree(package.payload);
+				package.payload = NULL;
 
-				else if (package.packType == PACK_TYPE_NETWORK_TEST_PACKAGE_FIRST || package.packType == PACK_TYPE_NETWORK_TEST_PACKAGE_SECOND)
+				//Delete Acknowledged package from all sendBuffer
+				packageBuffer_setCurrentPayloadNR(&sendBuffer[deviceNr],payloadNrTransmissionOk);
+				packageBuffer_freeOlderThanCurrentPackage(&sendBuffer[deviceNr]);
+				
+				while(packageBuffer_getPackageWithVar(&sendBuffer[deviceNr],&package,&numberOfSendTries,payloadNrToAck,&latency))
 				{
-					/* Copy payload out of testpackage */
-					tTestPackagePayload payload;
-					uint8_t *bytePtrPayload = (uint8_t*) &payload;
-					for (int i = 0; i < sizeof(tTestPackagePayload); i++)
-					{
-						bytePtrPayload[i] = package.payload[i];
-					}
-
-					/* Return the Testpackage if this device is not the Sender */
-					bool packIsFirstOfPair = false;
-					if(package.packType == PACK_TYPE_NETWORK_TEST_PACKAGE_FIRST)
-					{
-						packIsFirstOfPair = true;
-					}
-					if (!payload.returned && generateTestDataPackage(deviceNr, &package,true,packIsFirstOfPair))
-					{
-						if (pushToGeneratedPacksQueue(deviceNr,	&package) != pdTRUE)
-						{
-							vPortFree(package.payload);
-							package.payload = NULL;
-						}
-						popFromReceivedPayloadPacksQueue(deviceNr, &package);
-						vPortFree(package.payload);
-						package.payload = NULL;
-					}
+					vPortFree(package.payload);
+					package.payload = NULL;
 
-					/* Test-Packet returned from receiver */
-					else if(payload.returned)
+					if(!gotApack)
 					{
-						/* Update the timestamp with the received time */
-						//Copy payload out of testpackage
-						tTestPackagePayload payload;
-						uint8_t *bytePtrPayload = (uint8_t*) &payload;
-						for (int i = 0; i < sizeof(tTestPackagePayload); i++)
-						{
-							bytePtrPayload[i] = package.payload[i];
-						}
-						payload.sendTimestamp =  xTaskGetTickCount();
-						//Copy payload back into testpackage
-						bytePtrPayload = (uint8_t*) &payload;
-						for (int i = 0; i < sizeof(tTestPackagePayload); i++)
-						{
-							package.payload[i] = bytePtrPayload[i];
-						}
-
-						//Put the TestPackage into the queue for the NetworkMetrics
-						tWirelessPackage tempPack;
-						copyPackage(&package,&tempPack);
-						pushToTestPacketResultsQueue(&tempPack);
-						popFromReceivedPayloadPacksQueue(deviceNr, &package);
-						vPortFree(package.payload);
-						package.payload = NULL;
+						gotApack = true;
+						logger_logDeviceToDeviceLatency(package.devNum,(numberOfSendTries+1)*latency);
+						logger_logModemLatency(wirelessConnNr,latency);
 					}
 				}
+				congestionWindowPacksAcknowledged(deviceNr, nofPacksInFlight - sendBuffer[deviceNr].count);
+				networkMetrics_passiveAckReceived(wirelessConnNr, deviceNr, payloadNrToAck, payloadNrTransmissionOk);
 			}
 
+		/*--------------> Incoming Package == NetworkTestPackage <----------*/
 
-			/*------------------------ Resend Unacknowledged Wireless Packages ---------------------------*/
-			uint16_t numberOfResendAttempts;
-			while(packageBuffer_getNextPackageOlderThanTimeoutWithVar(&sendBuffer[deviceNr],&package,&numberOfResendAttempts,networkMetrics_getResendDelayWirelessConn()))
+			else if (package.packType == PACK_TYPE_NETWORK_TEST_PACKAGE_FIRST || package.packType == PACK_TYPE_NETWORK_TEST_PACKAGE_SECOND)
 			{
-				if(numberOfResendAttempts<config.ResendCountWirelessConn)  //Resend
+				/* Copy payload out of testpackage */
+				tTestPackagePayload payload;
+				uint8_t *bytePtrPayload = (uint8_t*) &payload;
+				for (int i = 0; i < sizeof(tTestPackagePayload); i++)
 				{
-					if(!packageBuffer_putWithVar(&sendBuffer[deviceNr],&package,(numberOfResendAttempts+1)))//Reinsert Package in the Buffer with new Timestamp
-					{
-						//Should never happen because place was freed 3 lines above... TODO Handle case
-					}
-					if (pushToGeneratedPacksQueue(deviceNr, &package) != pdTRUE)		//Put data-package into Queues
+					bytePtrPayload[i] = package.payload[i];
+				}
+
+				/* Return the Testpackage if this device is not the Sender */
+				bool packIsFirstOfPair = false;
+				if(package.packType == PACK_TYPE_NETWORK_TEST_PACKAGE_FIRST)
+				{
+					packIsFirstOfPair = true;
+				}
+				if (!payload.returned && generateTestDataPackage(deviceNr, &package,true,packIsFirstOfPair))
+				{
+					if (pushToGeneratedPacksQueue(deviceNr,	&package) != pdTRUE)
 					{
 						vPortFree(package.payload);
 						package.payload = NULL;
-						packageBuffer_getPackage(&sendBuffer[deviceNr],&package,package.payloadNr,&latency);
-						vPortFree(package.payload);
-						package.payload = NULL;
 					}
+					popFromReceivedPayloadPacksQueue(deviceNr, &package);
+					vPortFree(package.payload);
+					package.payload = NULL;
 				}
-				else												//Max Number of resends reached... Delete Package
+
+				/* Test-Packet returned from receiver */
+				else if(payload.returned)
 				{
-					logger_incrementDeviceFailedToSendPack(package.devNum);
+					/* Update the timestamp with the received time */
+					//Copy payload out of testpackage
+					tTestPackagePayload payload;
+					uint8_t *bytePtrPayload = (uint8_t*) &payload;
+					for (int i = 0; i < sizeof(tTestPackagePayload); i++)
+					{
+						bytePtrPayload[i] = package.payload[i];
+					}
+					payload.sendTimestamp =  xTaskGetTickCount();
+					//Copy payload back into testpackage
+					bytePtrPayload = (uint8_t*) &payload;
+					for (int i = 0; i < sizeof(tTestPackagePayload); i++)
+					{
+						package.payload[i] = bytePtrPayload[i];
+					}
+
+					//Put the TestPackage into the queue for the NetworkMetrics
+					tWirelessPackage tempPack;
+					copyPackage(&package,&tempPack);
+					pushToTestPacketResultsQueue(&tempPack);
+					popFromReceivedPayloadPacksQueue(deviceNr, &package);
 					vPortFree(package.payload);
 					package.payload = NULL;
 				}
 			}
+		}
 
 
-
-			/*------------------------ Send out all packages from the buffer which are in order ---------------------------*/
-			while(packageBuffer_getNextOrderedPackage(&receiveBuffer[deviceNr],&package))
+		/*------------------------ Resend Unacknowledged Wireless Packages ---------------------------*/
+		uint16_t numberOfResendAttempts;
+		while(packageBuffer_getNextPackageOlderThanTimeoutWithVar(&sendBuffer[deviceNr],&package,&numberOfResendAttempts,networkMetrics_getResendDelayWirelessConn()))
+		{
+			congestionWindowPackTimedOut(deviceNr, package.payloadNr);
+			if(numberOfResendAttempts<config.ResendCountWirelessConn)  //Resend
 			{
-				if(freeSpaceInTxByteQueue(MAX_14830_DEVICE_SIDE, package.devNum) >= package.payloadSize)
+				package.sendAttempt = numberOfResendAttempts + 2; //the first send was attempt 1
+				if(!packageBuffer_putWithVar(&sendBuffer[deviceNr],&package,(numberOfResendAttempts+1)))//Reinsert Package in the Buffer with new Timestamp
+				{
+					//Should never happen because place was freed 3 lines above... TODO Handle case
+				}
+				if (pushToGeneratedPacksQueue(deviceNr, &package) != pdTRUE)		//Put data-package into Queues
 				{
-					packageBuffer_setCurrentPayloadNR(&receiveBuffer[deviceNr], package.payloadNr);
-					pushPayloadOut(&package);
 					vPortFree(package.payload);
 					package.payload = NULL;
-					logger_incrementDeviceReceivedPack(package.devNum);
-				}
-				else
-				{	//If the TX Byte Queue hasnt enough space, the package gets reinserted into the Buffer
-					packageBuffer_put(&receiveBuffer[deviceNr],&package);
+					packageBuffer_getPackage(&sendBuffer[deviceNr],&package,package.payloadNr,&latency);
 					vPortFree(package.payload);
 					package.payload = NULL;
-					break;
 				}
 			}
-			/*------------------------ Delete received Wireless-Packets out of Order if timeOut has occurred ---------------------------*/
-			while(packageBuffer_getNextPackageOlderThanTimeout(&receiveBuffer[deviceNr],&package,config.PayloadReorderingTimeout))
+			else												//Max Number of resends reached... Delete Package
 			{
-				packageBuffer_setCurrentPayloadNR(&receiveBuffer[deviceNr], package.payloadNr);
+				logger_incrementDeviceFailedToSendPack(package.devNum);
 				vPortFree(package.payload);
 				package.payload = NULL;
-				logger_incrementDeletedOutOfOrderPacks(package.devNum);
 			}
-			
-			/*------------------------ Delete received Wireless-Packets with old payload---------------------------*/
-			packageBuffer_freeOlderThanCurrentPackage(&receiveBuffer[deviceNr]);
 		}
+
+
+
+		/*------------------------ Send out all packages from the buffer which are in order ---------------------------*/
+		numberOfPacksInReorderBuffer[deviceNr] = receiveBuffer[deviceNr].count;
+		if(numberOfPacksInReorderBuffer[deviceNr] > maxNumberOfPacksInReorderBuffer[deviceNr])
+		{
+			maxNumberOfPacksInReorderBuffer[deviceNr] = numberOfPacksInReorderBuffer[deviceNr];
+		}
+		pushOrderedPayloadsOut(deviceNr);
+
+		/*------------------------ Delete received Wireless-Packets out of Order if timeOut has occurred ---------------------------*/
+		while(reorderBuffer_skipToPackageOlderThanTimeout(&receiveBuffer[deviceNr],config.PayloadReorderingTimeout,&package))
+		{
+			vPortFree(package.payload);
+			package.payload = NULL;
+			logger_incrementDeletedOutOfOrderPacks(package.devNum);
+		}
+	}
+}
+
+/*!
+* \fn void transportHandler_notify(void)
+* \brief Wakes up the transport handler task when EVENT_DRIVEN_TASKS is configured. Called by the tasks which put work into its queues.
+*/
+void transportHandler_notify(void)
+{
+	if(config.EventDrivenTasks && (transportHandlerTaskHandle != NULL))
+	{
+		xTaskNotifyGive(transportHandlerTaskHandle);
 	}
 }
 
@@ -334,7 +417,10 @@ void transportHandler_TaskInit(void)
 	for(int i = 0; i<NUMBER_OF_UARTS; i++)
 	{
 		packageBuffer_init(&sendBuffer[i]);
-		packageBuffer_init(&receiveBuffer[i]);
+		reorderBuffer_init(&receiveBuffer[i]);
+		parityFec_initEncoder(&fecEncoder[i]);
+		parityFec_initDecoder(&fecDecoder[i]);
+		congestionWindow[i] = CONGESTION_WINDOW_INITIAL;
 	}
 
 #if PL_HAS_PERCEPIO
@@ -394,14 +480,22 @@ static bool generateDataPackage(tUartNr deviceNr, tWirelessPackage* pPackage)
 
 	uint16_t numberOfBytesInRxQueue = (uint16_t) numberOfBytesInRxByteQueue(MAX_14830_DEVICE_SIDE, deviceNr);
 	uint32_t timeWaitedForPackFull = xTaskGetTickCount()-tickTimeSinceFirstCharReceived[deviceNr];
+	uint16_t packetSize;
+	uint16_t maxPayloadSize = PACKAGE_MAX_PAYLOAD_SIZE;
 
 	if((deviceNr >= NUMBER_OF_UARTS) || (pPackage == NULL)) /* check validity of function parameters */
 	{
 		return false;
 	}
+	updateByteArrivalRate(deviceNr, numberOfBytesInRxQueue);
+	packetSize = getPacketSizeToGenerate(deviceNr);
+	if(config.FecParityGroupSize[deviceNr] > 0)
+	{
+		maxPayloadSize = FEC_MAX_DATA_PAYLOAD_SIZE; /* leave space for the header of the parity package */
+	}
 	/* check if enough data to fill package (when not configured to 0) or maximum wait time for full package done */
-	if( ( (numberOfBytesInRxQueue >= config.UsualPacketSizeDeviceConn[deviceNr]) && (0 != config.UsualPacketSizeDeviceConn[deviceNr]) ) ||
-		(numberOfBytesInRxQueue >= PACKAGE_MAX_PAYLOAD_SIZE) ||
+	if( ( (numberOfBytesInRxQueue >= packetSize) && (0 != packetSize) ) ||
+		(numberOfBytesInRxQueue >= maxPayloadSize) ||
 		( (dataWaitingToBeSent[deviceNr] == true) && (timeWaitedForPackFull >= pdMS_TO_TICKS(config.PackageGenMaxTimeout[deviceNr])) ) )
 	{
 		/* reached usual packet size or timeout, generate package
@@ -411,9 +505,9 @@ static bool generateDataPackage(tUartNr deviceNr, tWirelessPackage* pPackage)
 		 * Hopefully, this will do and no dropping of data on purpose is needed anywhere else for Rx side. */
 		/* limit payload of package */
 		//vTracePrint(appHandlerUserEvent[0], "enter");
-		if(numberOfBytesInRxQueue > PACKAGE_MAX_PAYLOAD_SIZE)
+		if(numberOfBytesInRxQueue > maxPayloadSize)
 		{
-			numberOfBytesInRxQueue = PACKAGE_MAX_PAYLOAD_SIZE;
+			numberOfBytesInRxQueue = maxPayloadSize;
 		}
 		/* Put together package */
 		/* put together payload by allocating memory and copy data */
@@ -438,6 +532,7 @@ static bool generateDataPackage(tUartNr deviceNr, tWirelessPackage* pPackage)
 				return false;
 			}
 		}
+		nofBytesInRxQueueAfterLastCall[deviceNr] -= numberOfBytesInRxQueue; /* popped bytes are no new arrivals */
 		/* put together the rest of the header */
 		pPackage->packType = PACK_TYPE_DATA_PACKAGE;
 		pPackage->devNum = deviceNr;
@@ -480,7 +575,7 @@ static bool generateAckPackage(tWirelessPackage* pReceivedDataPack, tWirelessPac
 	/* prepare wireless package */
 	pAckPack->packType = PACK_TYPE_REC_ACKNOWLEDGE;
 	pAckPack->devNum = pReceivedDataPack->devNum;
-	pAckPack->packNr = packageBuffer_getCurrentPayloadNR(&receiveBuffer[pReceivedDataPack->devNum]);
+	pAckPack->packNr = reorderBuffer_getCurrentPayloadNR(&receiveBuffer[pReceivedDataPack->devNum]);
 	pAckPack->payloadNr = pReceivedDataPack->payloadNr;
 	pAckPack->payloadSize = sizeof(int8_t);	/* as payload, the sent Modem Numer is saved */
 	/* get space for acknowladge payload (which consists of packNr of datapackage*/
@@ -496,32 +591,93 @@ static bool generateAckPackage(tWirelessPackage* pReceivedDataPack, tWirelessPac
 }
 
 /*!
-* \fn static void sendOutTestPackagePair(tUartNr deviceNr, tWirelessPackage* pPackage)
-* \brief Function to generate a test data package pair used to determine the network metrics
+* \fn static void rebuildLostPackage(tUartNr deviceNr, uint16_t firstPayloadNr, uint8_t receivedModemNr)
+* \brief Rebuilds the lost data packages of a parity group if possible, stores them in the receiveBuffer and acknowledges them,
+*  so the sender does not resend them.
+* \param firstPayloadNr: first payloadNr of the parity group (packNr of the received data or parity package)
+* \param receivedModemNr: modem where the last package of the group was received, the acknowledge goes back through it
 */
-static void sendOutTestPackagePair(tUartNr deviceNr, tWirelessPackage* pPackage)
+static void rebuildLostPackage(tUartNr deviceNr, uint16_t firstPayloadNr, uint8_t receivedModemNr)
 {
-	if(generateTestDataPackage(deviceNr, pPackage,false,true))
+	tWirelessPackage rebuiltPack, ackPack;
+
+	while(parityFec_rebuildLostPackage(&fecDecoder[deviceNr], firstPayloadNr, &rebuiltPack))
 	{
-		tWirelessPackage tempPack;
-		copyPackage(pPackage,&tempPack);
+		rebuiltPack.devNum = deviceNr;
+		rebuiltPack.receivedModemNr = receivedModemNr;
+		rebuiltPack.panicMode = remotePanicMode;
+		if(reorderBuffer_put(&receiveBuffer[deviceNr], &rebuiltPack) == REORDER_BUFFER_PUT_STORED)
+		{
+			numberOfRebuiltPacks[deviceNr]++;
+			if(generateAckPackage(&rebuiltPack, &ackPack) && pushToGeneratedPacksQueue(deviceNr, &ackPack) != pdTRUE)
+			{
+				vPortFree(ackPack.payload);
+				ackPack.payload = NULL;
+			}
+		}
+		vPortFree(rebuiltPack.payload);
+		rebuiltPack.payload = NULL;
+	}
+}
+
+/*!
+* \fn static void getFecBlockSize(tUartNr deviceNr, uint8_t* groupSize, uint8_t* nofParityPacks)
+* \brief Returns the group size and number of parity packages for the next FEC group. With FEC_PARITY_PACKS = 0,
+*  enough parity packages for FEC_ADAPTIVE_LOSS_FACTOR times the measured packet loss are used. If FEC_MAX_PARITY_PACKS
+*  are not enough, the group gets smaller.
+*/
+static void getFecBlockSize(tUartNr deviceNr, uint8_t* groupSize, uint8_t* nofParityPacks)
+{
+	uint32_t lossRatio = FEC_ADAPTIVE_LOSS_FACTOR * networkMetrics_getPacketLossRatio(); /* [per mille] */
+	uint32_t neededParityPacks;
 
-		pushToTestPacketResultsQueue(&tempPack);
-		if(pushToGeneratedPacksQueue(deviceNr, pPackage) != pdTRUE)
+	*groupSize = config.FecParityGroupSize[deviceNr];
+	if(config.FecParityPacks[deviceNr] > 0)
+	{
+		*nofParityPacks = config.FecParityPacks[deviceNr];
+		return;
+	}
+	neededParityPacks = (*groupSize * lossRatio + 999) / 1000; /* round up */
+	if(neededParityPacks > FEC_MAX_PARITY_PACKS)
+	{
+		neededParityPacks = FEC_MAX_PARITY_PACKS;
+		*groupSize = (FEC_MAX_PARITY_PACKS * 1000) / lossRatio;
+		if(*groupSize < 1)
 		{
-			vPortFree(pPackage->payload);
-			pPackage->payload = NULL;
+			*groupSize = 1;
 		}
 	}
-	if(generateTestDataPackage(deviceNr, pPackage,false,false))
+	if(neededParityPacks < 1)
+	{
+		neededParityPacks = 1;
+	}
+	*nofParityPacks = neededParityPacks;
+}
+
+/*!
+* \fn static void sendOutTestPackageTrain(tUartNr deviceNr, tWirelessPackage* pPackage)
+* \brief Function to generate a train of PROBE_TRAIN_LENGTH test data packages used to determine the network metrics.
+*  The first one is PACK_TYPE_NETWORK_TEST_PACKAGE_FIRST, all others PACK_TYPE_NETWORK_TEST_PACKAGE_SECOND.
+*  All test packages of the train carry the probe number in packNr.
+*/
+static void sendOutTestPackageTrain(tUartNr deviceNr, tWirelessPackage* pPackage)
+{
+	uint16_t probeNr = ++probeNumTracker[deviceNr];
+
+	for(int i = 0; i < config.ProbeTrainLengthWlConn[deviceNr]; i++)
 	{
-		tWirelessPackage tempPack;
-		copyPackage(pPackage,&tempPack);
-		pushToTestPacketResultsQueue(&tempPack);
-		if(pushToGeneratedPacksQueue(deviceNr, pPackage) != pdTRUE)
+		if(generateTestDataPackage(deviceNr, pPackage,false,(i == 0)))
 		{
-			vPortFree(pPackage->payload);
-			pPackage->payload = NULL;
+			tWirelessPackage tempPack;
+			pPackage->packNr = probeNr;
+			copyPackage(pPackage,&tempPack);
+
+			pushToTestPacketResultsQueue(&tempPack);
+			if(pushToGeneratedPacksQueue(deviceNr, pPackage) != pdTRUE)
+			{
+				vPortFree(pPackage->payload);
+				pPackage->payload = NULL;
+			}
 		}
 	}
 }
@@ -591,20 +747,44 @@ static bool generateTestDataPackage(tUartNr deviceNr, tWirelessPackage* pPackage
 }
 
 /*!
-* \fn static void pushPayloadOut(tWirelessPackage package)
-* \brief Pushes the payload of a wireless package out on the correct device
-* \param pPackage: pointer to package to be pushed out
+* \fn static void pushOrderedPayloadsOut(tUartNr deviceNr)
+* \brief Pushes the payloads of all packages in order out on the device. If the device byte queue is full,
+*  only a part of the payload is pushed out and the rest follows in the next cycle.
+* \param deviceNr: device where the payloads are pushed out
 */
-static void pushPayloadOut(tWirelessPackage* pPackage)
+static void pushOrderedPayloadsOut(tUartNr deviceNr)
 {
 	static char infoBuf[80];
-	for(uint16_t cnt=0; cnt<pPackage->payloadSize; cnt++)
+	uint8_t* payload;
+	uint16_t nofBytes;
+
+	while(reorderBuffer_getNextOrderedPayload(&receiveBuffer[deviceNr], &payload, &nofBytes))
 	{
-		if(pushToByteQueue(MAX_14830_DEVICE_SIDE, pPackage->devNum, &pPackage->payload[cnt]) == pdFAIL)
+		uint16_t freeSpace = freeSpaceInTxByteQueue(MAX_14830_DEVICE_SIDE, deviceNr);
+		if(nofBytes > freeSpace)
 		{
-			XF1_xsprintf(infoBuf, "%u: Warning: Push to device byte array for UART %u failed", xTaskGetTickCount(), pPackage->devNum);
-			pushMsgToShellQueue(infoBuf);
-			numberOfDroppedBytes[MAX_14830_WIRELESS_SIDE][pPackage->devNum]++;
+			nofBytes = freeSpace;
+		}
+		for(uint16_t cnt=0; cnt<nofBytes; cnt++)
+		{
+			if(pushToByteQueue(MAX_14830_DEVICE_SIDE, deviceNr, &payload[cnt]) == pdFAIL)
+			{
+				XF1_xsprintf(infoBuf, "%u: Warning: Push to device byte array for UART %u failed", xTaskGetTickCount(), deviceNr);
+				pushMsgToShellQueue(infoBuf);
+				numberOfDroppedBytes[MAX_14830_WIRELESS_SIDE][deviceNr]++;
+			}
+		}
+		if(nofBytes > 0)
+		{
+			spiHandler_notify();
+		}
+		if(reorderBuffer_consumeOrderedPayload(&receiveBuffer[deviceNr], nofBytes))
+		{
+			logger_incrementDeviceReceivedPack(deviceNr);
+		}
+		else
+		{
+			break; //Device byte queue is full, continue with this payload in the next cycle
 		}
 	}
 }
@@ -620,7 +800,13 @@ static BaseType_t pushToGeneratedPacksQueue(tUartNr uartNr, tWirelessPackage* pP
 {
 	if(uartNr < NUMBER_OF_UARTS)
 	{
-		return xQueueSendToBack(queueGeneratedPayloadPacks[uartNr], pPackage, ( TickType_t ) pdMS_TO_TICKS(TRANSPORT_HANDLER_QUEUE_DELAY) );
+		pPackage->tickTimeQueued = xTaskGetTickCount();
+		if(xQueueSendToBack(queueGeneratedPayloadPacks[uartNr], pPackage, ( TickType_t ) pdMS_TO_TICKS(TRANSPORT_HANDLER_QUEUE_DELAY) ) == pdTRUE)
+		{
+			networkHandler_notify();
+			return pdTRUE;
+		}
+		return pdFAIL;
 	}
 
 	return pdFAIL; /* if uartNr was not in range */
@@ -687,7 +873,12 @@ BaseType_t pushToReceivedPayloadPacksQueue(tUartNr uartNr, tWirelessPackage* pPa
 {
 	if(uartNr < NUMBER_OF_UARTS)
 	{
-		return xQueueSendToBack(queueReceivedPayloadPacks[uartNr], pPackage, ( TickType_t ) pdMS_TO_TICKS(TRANSPORT_HANDLER_QUEUE_DELAY) );
+		if(xQueueSendToBack(queueReceivedPayloadPacks[uartNr], pPackage, ( TickType_t ) pdMS_TO_TICKS(TRANSPORT_HANDLER_QUEUE_DELAY) ) == pdTRUE)
+		{
+			transportHandler_notify();
+			return pdTRUE;
+		}
+		return pdFAIL;
 	}
 	return pdFAIL; /* if uartNr was not in range */
 }
@@ -769,11 +960,11 @@ static void checkSessionNr(tWirelessPackage* pPackage)
 	{
 		for(int i = 0 ; i < NUMBER_OF_UARTS ; i++)
 		{
-			packageBuffer_free(&receiveBuffer[i]);
+			reorderBuffer_free(&receiveBuffer[i], 0);
 		}
 
 		if(pPackage->packType == PACK_TYPE_DATA_PACKAGE)
-			packageBuffer_setCurrentPayloadNR(&receiveBuffer[pPackage->devNum], pPackage->payloadNr);
+			reorderBuffer_free(&receiveBuffer[pPackage->devNum], pPackage->payloadNr - 1);
 		lastSessionNr = pPackage->sessionNr;
 	}
 }
@@ -797,3 +988,174 @@ static bool copyPackage(tWirelessPackage* original, tWirelessPackage* copy)
 	}
 	return true;
 }
+
+/*!
+* \fn static bool congestionWindowIsFull(tUartNr deviceNr)
+* \brief Checks if the device has as many unacknowledged data packages in flight as its sending window allows
+* \return true if no new data package should be generated for this device
+*/
+static bool congestionWindowIsFull(tUartNr deviceNr)
+{
+	if(config.CongestionWindowMaxDeviceConn[deviceNr] == 0) /* no congestion control configured for this device */
+	{
+		return false;
+	}
+	return (sendBuffer[deviceNr].count >= getCongestionWindowLimit(deviceNr));
+}
+
+/*!
+* \fn static uint16_t getCongestionWindowLimit(tUartNr deviceNr)
+* \brief Returns the sending window of the device, limited by CONGESTION_WINDOW_MAX and by the share
+*  of the estimated bandwidth delay product of the wireless links for this device
+* \return max number of unacknowledged data packages
+*/
+static uint16_t getCongestionWindowLimit(tUartNr deviceNr)
+{
+	uint16_t nofActiveDevices = 1;
+	uint32_t bytesPerPackage = TOTAL_WL_PACKAGE_SIZE + PACKAGE_MAX_PAYLOAD_SIZE;
+	uint32_t bandwidthLimit;
+	uint16_t windowLimit = congestionWindow[deviceNr];
+
+	/* the wireless links are shared between all devices with data in flight */
+	for(int i = 0; i < NUMBER_OF_UARTS; i++)
+	{
+		if(i != deviceNr && sendBuffer[i].count > 0)
+		{
+			nofActiveDevices++;
+		}
+	}
+	if(getPacketSizeToGenerate(deviceNr) != 0)
+	{
+		bytesPerPackage = TOTAL_WL_PACKAGE_SIZE + getPacketSizeToGenerate(deviceNr);
+	}
+	bandwidthLimit = networkMetrics_getBandwidthDelayProduct() / nofActiveDevices / bytesPerPackage;
+
+	if(windowLimit > bandwidthLimit)
+	{
+		windowLimit = bandwidthLimit;
+	}
+	if(windowLimit > config.CongestionWindowMaxDeviceConn[deviceNr])
+	{
+		windowLimit = config.CongestionWindowMaxDeviceConn[deviceNr];
+	}
+	if(windowLimit < CONGESTION_WINDOW_MIN)
+	{
+		windowLimit = CONGESTION_WINDOW_MIN;
+	}
+	return windowLimit;
+}
+
+/*!
+* \fn static void congestionWindowPacksAcknowledged(tUartNr deviceNr, uint16_t nofAcknowledgedPacks)
+* \brief Additive increase: the sending window grows by one package per fully acknowledged window
+* \param nofAcknowledgedPacks: Number of packages which were removed from the sendBuffer by the acknowledge
+*/
+static void congestionWindowPacksAcknowledged(tUartNr deviceNr, uint16_t nofAcknowledgedPacks)
+{
+	congestionWindowAckCounter[deviceNr] += nofAcknowledgedPacks;
+	if(congestionWindowAckCounter[deviceNr] >= congestionWindow[deviceNr])
+	{
+		congestionWindowAckCounter[deviceNr] = 0;
+		if(congestionWindow[deviceNr] < config.CongestionWindowMaxDeviceConn[deviceNr])
+		{
+			congestionWindow[deviceNr]++;
+		}
+	}
+}
+
+/*!
+* \fn static void congestionWindowPackTimedOut(tUartNr deviceNr, uint16_t payloadNr)
+* \brief Multiplicative decrease: the sending window is halved when a package was not acknowledged in time.
+*  Packages which were already in flight at the last decrease do not shrink the window again.
+* \param payloadNr: payloadNr of the package that timed out
+*/
+static void congestionWindowPackTimedOut(tUartNr deviceNr, uint16_t payloadNr)
+{
+	if(packageBuffer_isNewerPayloadNr(payloadNr, congestionRecoveryPayloadNr[deviceNr]))
+	{
+		congestionWindow[deviceNr] /= 2;
+		if(congestionWindow[deviceNr] < CONGESTION_WINDOW_MIN)
+		{
+			congestionWindow[deviceNr] = CONGESTION_WINDOW_MIN;
+		}
+		congestionWindowAckCounter[deviceNr] = 0;
+		congestionRecoveryPayloadNr[deviceNr] = payloadNumTracker[deviceNr];
+	}
+}
+
+/*!
+* \fn static void updateByteArrivalRate(tUartNr deviceNr, uint16_t numberOfBytesInRxQueue)
+* \brief Measures how many bytes per second arrive on the device side. Needs to be called before bytes are
+*  popped from the device byte queue.
+* \param numberOfBytesInRxQueue: Number of bytes currently waiting in the device byte queue
+*/
+static void updateByteArrivalRate(tUartNr deviceNr, uint16_t numberOfBytesInRxQueue)
+{
+	static TickType_t tickTimeLastMeasurement[NUMBER_OF_UARTS];
+	static uint32_t nofArrivedBytes[NUMBER_OF_UARTS];
+	TickType_t timeSinceLastMeasurement = xTaskGetTickCount() - tickTimeLastMeasurement[deviceNr];
+
+	if(numberOfBytesInRxQueue > nofBytesInRxQueueAfterLastCall[deviceNr])
+	{
+		nofArrivedBytes[deviceNr] += numberOfBytesInRxQueue - nofBytesInRxQueueAfterLastCall[deviceNr];
+	}
+	nofBytesInRxQueueAfterLastCall[deviceNr] = numberOfBytesInRxQueue;
+
+	if(timeSinceLastMeasurement >= pdMS_TO_TICKS(BYTE_ARRIVAL_RATE_MEASURE_INTERVAL))
+	{
+		uint32_t rawRate = (nofArrivedBytes[deviceNr] * 1000) / (timeSinceLastMeasurement * portTICK_PERIOD_MS);
+		byteArrivalRate[deviceNr] = (byteArrivalRate[deviceNr] * 7 + rawRate) / 8; /* exponential filter */
+		nofArrivedBytes[deviceNr] = 0;
+		tickTimeLastMeasurement[deviceNr] = xTaskGetTickCount();
+	}
+}
+
+/*!
+* \fn static uint16_t getPacketSizeToGenerate(tUartNr deviceNr)
+* \brief Returns the payload size at which a data package is generated.
+*  In adaptive mode the smallest size is chosen for which payload plus header bytes of all devices still fit into
+*  ADAPTIVE_PACKET_SIZE_LINK_USAGE of the wireless bandwidth: size >= rate*header / (usableBandwidth - rate).
+*  A size above the bytes that arrive within PACKAGE_GEN_MAX_TIMEOUT is not useful, the timeout would send it anyway.
+* \return payload size in bytes, 0 if the package is only generated by timeout
+*/
+static uint16_t getPacketSizeToGenerate(tUartNr deviceNr)
+{
+	uint32_t totalArrivalRate = 0;
+	uint32_t usableBandwidth;
+	uint32_t packetSize;
+	uint32_t bytesWithinTimeout;
+
+	if(!config.AdaptivePacketSizeDeviceConn[deviceNr])
+	{
+		return config.UsualPacketSizeDeviceConn[deviceNr];
+	}
+	for(int i = 0; i < NUMBER_OF_UARTS; i++)
+	{
+		totalArrivalRate += byteArrivalRate[i];
+	}
+	usableBandwidth = (networkMetrics_getBandwidth() * ADAPTIVE_PACKET_SIZE_LINK_USAGE) / 100;
+
+	if(usableBandwidth <= totalArrivalRate) /* links are saturated -> least header overhead */
+	{
+		packetSize = PACKAGE_MAX_PAYLOAD_SIZE;
+	}
+	else
+	{
+		packetSize = (totalArrivalRate * TOTAL_WL_PACKAGE_SIZE) / (usableBandwidth - totalArrivalRate) + 1;
+	}
+
+	bytesWithinTimeout = (byteArrivalRate[deviceNr] * config.PackageGenMaxTimeout[deviceNr]) / 1000;
+	if(packetSize > bytesWithinTimeout)
+	{
+		packetSize = bytesWithinTimeout;
+	}
+	if(packetSize > PACKAGE_MAX_PAYLOAD_SIZE)
+	{
+		packetSize = PACKAGE_MAX_PAYLOAD_SIZE;
+	}
+	if(packetSize < 1) /* sparse traffic -> send out immediately */
+	{
+		packetSize = 1;
+	}
+	return (uint16_t)packetSize;
+}